@@ -0,0 +1,597 @@
+// ============================================================================
+// Бенчмарк алгоритмов поиска: kmp_search, KmpPattern, AhoSearch, AhoCorasick,
+// PatternMatcher, SinglePattern (memchr, Horspool, Two-Way), SuffixIndex, ApproxPattern,
+// LivePatternSet, KmpStream/AcStream по файлу частями, std::search и std::boyer_moore_horspool_searcher на синтетических данных
+// в формате data.txt. Результаты выводятся в JSON.
+//
+// Сборка:  g++ -std=c++17 -O2 -pthread -o lab2.1-bench bench/bench.cpp
+// Запуск:  ./lab2.1-bench [--max-text BYTES] [--max-patterns N] [--seed S]
+//                         [--budget-ms MS] [--out FILE]
+//          ./lab2.1-bench --generate FILE BYTES   (записать синтетический data.txt)
+// ============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/ac.hpp"
+#include "../src/approx.hpp"
+#include "../src/dynamic.hpp"
+#include "../src/kmp.hpp"
+#include "../src/planner.hpp"
+#include "../src/profile.hpp"
+#include "../src/records.hpp"
+#include "../src/smallset.hpp"
+#include "../src/suffix.hpp"
+#include "datagen.hpp"
+
+// Подсчёт выделений памяти: глобальный operator new заменяется на счётчик
+// (см. profile.hpp), чтобы для каждого запроса посчитать число аллокаций.
+LAB_DEFINE_COUNTING_NEW
+
+// Логика измерения:
+// 1. Запрос — один полный проход движка по тексту со всеми шаблонами набора.
+// 2. Запрос повторяется, пока не истечёт бюджет времени (но не меньше MIN_REPS
+//    и не больше MAX_REPS раз); длительность каждого повтора сохраняется.
+// 3. По длительностям считаются перцентили p50/p90/p99, пропускная способность —
+//    по медиане, аллокации — среднее число на запрос.
+
+struct Options {
+    size_t maxText = size_t{64} << 20;
+    size_t maxPatterns = 100000;
+    uint64_t seed = 2720;
+    double budgetMs = 300.0;
+    std::string out;
+};
+
+struct Result {
+    std::string suite;
+    std::string engine;
+    size_t patternLength;
+    size_t patterns;
+    size_t textBytes;
+    size_t reps;
+    uint64_t matches;
+    double gbps;
+    double allocsPerQuery;
+    double p50Ns;
+    double p90Ns;
+    double p99Ns;
+    // Для AhoCorasick — размер автомата (AhoCorasick::stats()), для остальных — 0.
+    size_t states = 0;
+    size_t automatonBytes = 0;
+    // Для набора "index" в automatonBytes — размер суффиксного индекса.
+    // Для набора "updates" задержка обновления — в перцентилях, а textBytes = 0.
+    // Для набора "layout": бюджет памяти (SIZE_MAX — без ограничения), число плотных
+    // узлов и время построения.
+    size_t budgetBytes = SIZE_MAX;
+    size_t denseStates = 0;
+    double buildMs = 0;
+};
+
+constexpr size_t MIN_REPS = 3;
+constexpr size_t MAX_REPS = 1000;
+
+// Движки с одним шаблоном на вызов. Для наборов из нескольких шаблонов вызываются
+// по одному разу на шаблон.
+using SingleRunner = std::function<uint64_t(const std::string& text, const std::string& pattern)>;
+
+uint64_t RunKmpSearch(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    size_t* matches = kmp_search(text, pattern, &count);
+    free(matches);
+    return count;
+}
+
+uint64_t RunStdSearch(const std::string& text, const std::string& pattern) {
+    uint64_t count = 0;
+    auto it = text.begin();
+    while ((it = std::search(it, text.end(), pattern.begin(), pattern.end())) != text.end()) {
+        ++count;
+        ++it;
+    }
+    return count;
+}
+
+uint64_t RunHorspool(const std::string& text, const std::string& pattern) {
+    const std::boyer_moore_horspool_searcher searcher(pattern.begin(), pattern.end());
+    uint64_t count = 0;
+    auto it = text.begin();
+    for (;;) {
+        it = std::search(it, text.end(), searcher);
+        if (it == text.end()) {
+            break;
+        }
+        ++count;
+        ++it;
+    }
+    return count;
+}
+
+double Percentile(std::vector<double> sorted, double q) {
+    std::sort(sorted.begin(), sorted.end());
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+template <typename Query>
+Result Measure(const Options& opt, const std::string& suite, const std::string& engine,
+               size_t patternLength, size_t patterns, size_t textBytes, Query&& query) {
+    std::vector<double> times;
+    uint64_t matches = 0;
+    uint64_t allocations = 0;
+    double total = 0;
+
+    while (times.size() < MAX_REPS && (times.size() < MIN_REPS || total < opt.budgetMs * 1e6)) {
+        const uint64_t allocBefore = ProfileAllocations().load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        matches = query();
+        const auto end = std::chrono::steady_clock::now();
+        allocations += ProfileAllocations().load(std::memory_order_relaxed) - allocBefore;
+
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        times.push_back(ns);
+        total += ns;
+    }
+
+    const double p50 = Percentile(times, 0.50);
+    return Result{suite, engine, patternLength, patterns, textBytes, times.size(), matches,
+                  p50 > 0 ? static_cast<double>(textBytes) / p50 : 0.0,
+                  static_cast<double>(allocations) / static_cast<double>(times.size()),
+                  p50, Percentile(times, 0.90), Percentile(times, 0.99)};
+}
+
+std::vector<size_t> TextSizes(const Options& opt) {
+    std::vector<size_t> sizes;
+    for (size_t s = 1024; s <= opt.maxText; s *= 16) {
+        sizes.push_back(s);
+    }
+    if (opt.maxText >= (size_t{1} << 30)) {
+        sizes.push_back(size_t{1} << 30);
+    }
+    return sizes;
+}
+
+void RunSingleSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    const std::vector<std::pair<std::string, SingleRunner>> engines = {
+        {"kmp_search", RunKmpSearch},
+        {"std::search", RunStdSearch},
+        {"std::boyer_moore_horspool_searcher", RunHorspool},
+    };
+
+    for (const size_t length : {1, 4, 16, 64}) {
+        const std::string pattern = SamplePatterns(text, 1, length, opt.seed + length).front();
+
+        for (const auto& [name, engine] : engines) {
+            results.push_back(Measure(opt, "single", name, length, 1, text.size(),
+                                      [&, &engine = engine] { return engine(text, pattern); }));
+        }
+
+        const KmpPattern compiled(pattern);
+        results.push_back(Measure(opt, "single", "KmpPattern", length, 1, text.size(),
+                                  [&] { return static_cast<uint64_t>(compiled.count(text)); }));
+
+        // Все движки планировщика на одном шаблоне и движок, который он выбрал сам.
+        for (const SingleEngine engine : {SingleEngine::Memchr, SingleEngine::Horspool, SingleEngine::TwoWay}) {
+            if (engine == SingleEngine::Memchr && length != 1) {
+                continue;
+            }
+            const SinglePattern forced(pattern, CaseMode::Sensitive, engine);
+            results.push_back(Measure(opt, "single", std::string("SinglePattern/") + SingleEngineName(engine), length, 1,
+                                      text.size(), [&] { return static_cast<uint64_t>(forced.count(text)); }));
+        }
+        const SinglePattern planned(pattern, CaseMode::Sensitive, text.size());
+        results.push_back(Measure(opt, "single", std::string("SinglePattern(plan: ") + SingleEngineName(planned.engine()) + ")",
+                                  length, 1, text.size(), [&] { return static_cast<uint64_t>(planned.count(text)); }));
+    }
+}
+
+void RunMultiSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    constexpr size_t LENGTH = 8;
+    // Движки с одним шаблоном на вызов на больших наборах работают часами —
+    // для них набор ограничен.
+    constexpr size_t MAX_SINGLE_ENGINE_PATTERNS = 100;
+
+    for (size_t count = 1; count <= opt.maxPatterns; count *= 10) {
+        const auto patterns = SamplePatterns(text, count, LENGTH, opt.seed + count);
+
+        const AhoCorasick ac(patterns);
+        results.push_back(Measure(opt, "multi", "AhoCorasick", LENGTH, count, text.size(), [&] {
+            uint64_t matches = 0;
+            ac.search(text, [&matches](size_t, uint32_t) { ++matches; });
+            return matches;
+        }));
+        const AhoCorasick::Stats stats = ac.stats();
+        results.back().states = stats.states;
+        results.back().automatonBytes = stats.totalBytes;
+
+        results.push_back(Measure(opt, "multi", "AhoSearch", LENGTH, count, text.size(), [&] {
+            return static_cast<uint64_t>(AhoSearch(text, patterns, patterns.size()));
+        }));
+
+        if (count > MAX_SINGLE_ENGINE_PATTERNS) {
+            continue;
+        }
+
+        std::vector<KmpPattern> compiled(patterns.begin(), patterns.end());
+        results.push_back(Measure(opt, "multi", "KmpPattern", LENGTH, count, text.size(), [&] {
+            uint64_t matches = 0;
+            for (const auto& p : compiled) {
+                matches += p.count(text);
+            }
+            return matches;
+        }));
+
+        results.push_back(Measure(opt, "multi", "std::boyer_moore_horspool_searcher", LENGTH, count, text.size(), [&] {
+            uint64_t matches = 0;
+            for (const auto& p : patterns) {
+                matches += RunHorspool(text, p);
+            }
+            return matches;
+        }));
+    }
+}
+
+// Небольшие наборы: PatternMatcher (байтовое множество или Teddy) против автомата на
+// тех же шаблонах — набор из main.cpp и выборки по 2, 4 и 8 коротких шаблонов.
+void RunSmallSetSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    std::vector<std::vector<std::string>> sets = {{"6", "2", "8", "7"}};
+    for (const size_t count : {2, 4, 8}) {
+        sets.push_back(SamplePatterns(text, count, 4, opt.seed + 100 + count));
+    }
+    const char* engineNames[] = {"PatternMatcher/ByteSet", "PatternMatcher/Teddy", "PatternMatcher/AhoCorasick"};
+
+    for (const auto& patterns : sets) {
+        const size_t length = patterns.front().size();
+        const PatternMatcher matcher(patterns);
+        results.push_back(Measure(opt, "smallset", engineNames[static_cast<size_t>(matcher.engine())], length,
+                                  patterns.size(), text.size(), [&] {
+            uint64_t matches = 0;
+            matcher.search(text, [&matches](size_t, uint32_t) { ++matches; });
+            return matches;
+        }));
+
+        const AhoCorasick ac(patterns);
+        results.push_back(Measure(opt, "smallset", "AhoCorasick", length, patterns.size(), text.size(), [&] {
+            uint64_t matches = 0;
+            ac.search(text, [&matches](size_t, uint32_t) { ++matches; });
+            return matches;
+        }));
+    }
+}
+
+// Компромисс память/скорость гибридного автомата: один словарь строится с бюджетами
+// от полной плотной таблицы до минимального, для каждого — байт на шаблон и скорость.
+void RunLayoutSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    constexpr size_t LENGTH = 8;
+    const size_t count = opt.maxPatterns;
+    const auto patterns = SamplePatterns(text, count, LENGTH, opt.seed + 7);
+
+    size_t fullBytes = 0;
+    for (const size_t divisor : {1, 4, 16, 64, 0}) {
+        // divisor 0 — бюджет 0: плотный только корень.
+        const size_t budget = divisor == 0 ? 0 : (divisor == 1 ? SIZE_MAX : fullBytes / divisor);
+        const auto start = std::chrono::steady_clock::now();
+        const AhoCorasick ac(patterns, CaseMode::Sensitive, budget);
+        const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const AhoCorasick::Stats stats = ac.stats();
+        if (divisor == 1) {
+            fullBytes = stats.totalBytes;
+        }
+
+        results.push_back(Measure(opt, "layout", "AhoCorasick", LENGTH, count, text.size(), [&] {
+            uint64_t matches = 0;
+            ac.search(text, [&matches](size_t, uint32_t) { ++matches; });
+            return matches;
+        }));
+        Result& r = results.back();
+        r.states = stats.states;
+        r.automatonBytes = stats.totalBytes;
+        r.budgetBytes = budget;
+        r.denseStates = stats.denseStates;
+        r.buildMs = buildMs;
+    }
+}
+
+// Суффиксный индекс против просмотра корпуса: текст разбирается в записи, индекс
+// строится один раз, затем count и locate по индексу сравниваются с SinglePattern по
+// всем полям. Индекс строится только для текстов до INDEX_MAX_TEXT: SA-IS требует
+// ~6 байт памяти на байт текста.
+constexpr size_t INDEX_MAX_TEXT = size_t{64} << 20;
+
+void RunIndexSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    if (text.size() > INDEX_MAX_TEXT) {
+        return;
+    }
+    const RecordStore words = LinesWithWordsColumnar(text);
+    const auto start = std::chrono::steady_clock::now();
+    const SuffixIndex index(words);
+    const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (const size_t length : {1, 4, 16}) {
+        const std::string pattern = SamplePatterns(text, 1, length, opt.seed + 200 + length).front();
+
+        results.push_back(Measure(opt, "index", "SuffixIndex::count", length, 1, text.size(),
+                                  [&] { return static_cast<uint64_t>(index.count(pattern)); }));
+        results.back().automatonBytes = index.memoryBytes();
+        results.back().buildMs = buildMs;
+
+        results.push_back(Measure(opt, "index", "SuffixIndex::locate", length, 1, text.size(),
+                                  [&] { return static_cast<uint64_t>(index.locate(pattern).size()); }));
+        results.back().automatonBytes = index.memoryBytes();
+        results.back().buildMs = buildMs;
+
+        const SinglePattern scan(pattern, CaseMode::Sensitive, words.bytes() / std::max<size_t>(words.size() * 3, 1));
+        results.push_back(Measure(opt, "index", "SinglePattern (fields)", length, 1, text.size(), [&] {
+            uint64_t matches = 0;
+            for (const RecordView v : words) {
+                for (size_t g = 0; g < RecordView::size(); ++g) {
+                    matches += scan.count(v[g]);
+                }
+            }
+            return matches;
+        }));
+    }
+}
+
+// Приближённый поиск по полям, как в main.cpp: ApproxPattern (Bitap для замен,
+// Майерс для правок) с k = 1 и 2 против точного SinglePattern на тех же полях.
+void RunApproxSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    const RecordStore words = LinesWithWordsColumnar(text);
+    auto scanFields = [&words](const auto& pattern) {
+        uint64_t matches = 0;
+        for (const RecordView v : words) {
+            for (size_t g = 0; g < RecordView::size(); ++g) {
+                matches += pattern.count(v[g]);
+            }
+        }
+        return matches;
+    };
+
+    for (const size_t length : {4, 8, 16}) {
+        const std::string pattern = SamplePatterns(text, 1, length, opt.seed + 300 + length).front();
+
+        const SinglePattern exact(pattern, CaseMode::Sensitive, words.bytes() / std::max<size_t>(words.size() * 3, 1));
+        results.push_back(Measure(opt, "approx", "SinglePattern (exact)", length, 1, text.size(),
+                                  [&] { return scanFields(exact); }));
+
+        for (const uint32_t k : {1u, 2u}) {
+            for (const ApproxMetric metric : {ApproxMetric::Hamming, ApproxMetric::Levenshtein}) {
+                const ApproxPattern approx(pattern, k, metric);
+                const std::string name = std::string("ApproxPattern/") +
+                                         (metric == ApproxMetric::Hamming ? "Bitap" : "Myers") +
+                                         " k=" + std::to_string(k);
+                results.push_back(Measure(opt, "approx", name, length, 1, text.size(),
+                                          [&] { return scanFields(approx); }));
+            }
+        }
+    }
+}
+
+// Набор "stream": текст записывается во временный файл, который ScanFileStream читает
+// частями разного размера. KmpStream и AcStream должны найти те же вхождения с теми же
+// смещениями от начала файла, что и поиск по всему тексту, — в том числе на стыках частей;
+// иначе набор завершается ошибкой.
+void RunStreamSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    constexpr size_t KMP_LENGTH = 16;
+    constexpr size_t AC_LENGTH = 8;
+    constexpr size_t AC_PATTERNS = 100;
+    const std::string path = (std::filesystem::temp_directory_path() / "lab2.1-bench-stream.txt").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file || !file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            throw std::runtime_error("Failed to write file: " + path);
+        }
+    }
+
+    const KmpPattern kmp(SamplePatterns(text, 1, KMP_LENGTH, opt.seed + 500).front());
+    const AhoCorasick ac(SamplePatterns(text, AC_PATTERNS, AC_LENGTH, opt.seed + 501));
+    // Контрольная сумма вхождений: пропущенное или сдвинутое вхождение её меняет.
+    uint64_t kmpExpected = 0;
+    kmp.search(text, [&kmpExpected](size_t pos) { kmpExpected += pos + 1; });
+    uint64_t acExpected = 0;
+    ac.search(text, [&acExpected](size_t end, uint32_t pattern) { acExpected += end * AC_PATTERNS + pattern; });
+
+    for (const size_t chunk : {size_t{4} << 10, size_t{64} << 10, ChunkReader::DEFAULT_CHUNK}) {
+        uint64_t kmpSum = 0;
+        results.push_back(Measure(opt, "stream", "KmpStream/" + std::to_string(chunk), KMP_LENGTH, 1, text.size(), [&] {
+            KmpStream stream(kmp);
+            uint64_t matches = 0;
+            kmpSum = 0;
+            ScanFileStream(path, chunk, stream, [&](uint64_t pos) {
+                ++matches;
+                kmpSum += pos + 1;
+            });
+            return matches;
+        }));
+
+        uint64_t acSum = 0;
+        results.push_back(Measure(opt, "stream", "AcStream/" + std::to_string(chunk), AC_LENGTH, AC_PATTERNS,
+                                  text.size(), [&] {
+            AcStream stream(ac);
+            uint64_t matches = 0;
+            acSum = 0;
+            ScanFileStream(path, chunk, stream, [&](uint64_t end, uint32_t pattern) {
+                ++matches;
+                acSum += end * AC_PATTERNS + pattern;
+            });
+            return matches;
+        }));
+
+        if (kmpSum != kmpExpected || acSum != acExpected) {
+            std::remove(path.c_str());
+            throw std::runtime_error("Stream search differs from the whole-text search, chunk " + std::to_string(chunk));
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// Набор "updates": задержка обновления словаря — полная перестройка AhoCorasick
+// против add/remove в LivePatternSet — и скорость поиска по снимку до и после
+// фонового слияния сравнительно с автоматом, построенным заново.
+constexpr size_t UPDATE_PATTERNS = 16;
+
+void RunUpdateSuite(const Options& opt, const std::string& text, std::vector<Result>& results) {
+    constexpr size_t LENGTH = 8;
+    const size_t count = opt.maxPatterns;
+    const auto patterns = SamplePatterns(text, count, LENGTH, opt.seed + 400);
+    const auto pool = SamplePatterns(text, UPDATE_PATTERNS * MAX_REPS, LENGTH, opt.seed + 401);
+    auto searchText = [&text](const auto& matcher) {
+        uint64_t matches = 0;
+        matcher.search(text, [&matches](size_t, uint32_t) { ++matches; });
+        return matches;
+    };
+
+    std::vector<std::string> grown = patterns;
+    size_t next = 0;
+    results.push_back(Measure(opt, "updates", "AhoCorasick (rebuild)", LENGTH, count, 0, [&] {
+        grown.insert(grown.end(), pool.begin() + static_cast<std::ptrdiff_t>(next),
+                     pool.begin() + static_cast<std::ptrdiff_t>(next + UPDATE_PATTERNS));
+        next += UPDATE_PATTERNS;
+        return static_cast<uint64_t>(AhoCorasick(grown).size());
+    }));
+
+    LivePatternSet live(patterns);
+    live.waitForMerge();
+    next = 0;
+    results.push_back(Measure(opt, "updates", "LivePatternSet::add", LENGTH, count, 0, [&] {
+        const std::vector<std::string> update(pool.begin() + static_cast<std::ptrdiff_t>(next),
+                                              pool.begin() + static_cast<std::ptrdiff_t>(next + UPDATE_PATTERNS));
+        next += UPDATE_PATTERNS;
+        return static_cast<uint64_t>(live.add(update).size());
+    }));
+    uint32_t removed = 0;
+    results.push_back(Measure(opt, "updates", "LivePatternSet::remove", LENGTH, count, 0, [&] {
+        std::vector<uint32_t> ids(UPDATE_PATTERNS);
+        for (uint32_t& id : ids) {
+            id = removed++;
+        }
+        return static_cast<uint64_t>(live.remove(ids));
+    }));
+    live.waitForMerge();
+
+    const std::shared_ptr<const PatternSnapshot> merged = live.snapshot();
+    const AhoCorasick rebuilt(patterns);
+    results.push_back(Measure(opt, "updates", "AhoCorasick", LENGTH, count, text.size(),
+                              [&] { return searchText(rebuilt); }));
+    results.push_back(Measure(opt, "updates", "PatternSnapshot (merged)", LENGTH, count, text.size(),
+                              [&] { return searchText(*merged); }));
+    // Снимок сразу после add: новый сегмент ещё не слит с основным.
+    live.add(std::vector<std::string>(pool.begin(), pool.begin() + UPDATE_PATTERNS));
+    const std::shared_ptr<const PatternSnapshot> pending = live.snapshot();
+    results.push_back(Measure(opt, "updates",
+                              "PatternSnapshot (" + std::to_string(pending->segmentCount()) + " segments)", LENGTH,
+                              count, text.size(), [&] { return searchText(*pending); }));
+}
+
+std::string JsonEscape(const std::string& s) {
+    std::string out;
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+void WriteJson(std::ostream& out, const Options& opt, const std::vector<Result>& results) {
+    out << "{\n  \"meta\": {\"seed\": " << opt.seed << ", \"max_text\": " << opt.maxText
+        << ", \"max_patterns\": " << opt.maxPatterns << ", \"budget_ms\": " << opt.budgetMs << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"suite\": \"" << r.suite << "\", \"engine\": \"" << JsonEscape(r.engine) << "\""
+            << ", \"pattern_length\": " << r.patternLength << ", \"patterns\": " << r.patterns
+            << ", \"text_bytes\": " << r.textBytes << ", \"reps\": " << r.reps
+            << ", \"matches\": " << r.matches << ", \"gbps\": " << r.gbps
+            << ", \"allocs_per_query\": " << r.allocsPerQuery << ", \"p50_ns\": " << r.p50Ns
+            << ", \"p90_ns\": " << r.p90Ns << ", \"p99_ns\": " << r.p99Ns
+            << ", \"states\": " << r.states << ", \"automaton_bytes\": " << r.automatonBytes
+            << ", \"bytes_per_pattern\": " << (r.patterns ? static_cast<double>(r.automatonBytes) / r.patterns : 0.0)
+            << ", \"budget_bytes\": " << (r.budgetBytes == SIZE_MAX ? std::string("null") : std::to_string(r.budgetBytes))
+            << ", \"dense_states\": " << r.denseStates
+            << ", \"build_ms\": " << r.buildMs << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options opt;
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        auto value = [&]() -> std::string {
+            if (a + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            return argv[++a];
+        };
+        if (arg == "--max-text") {
+            opt.maxText = std::stoull(value());
+        } else if (arg == "--max-patterns") {
+            opt.maxPatterns = std::stoull(value());
+        } else if (arg == "--seed") {
+            opt.seed = std::stoull(value());
+        } else if (arg == "--budget-ms") {
+            opt.budgetMs = std::stod(value());
+        } else if (arg == "--out") {
+            opt.out = value();
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return opt;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && std::string(argv[1]) == "--generate") {
+        std::ofstream file(argv[2], std::ios::binary);
+        if (!file) {
+            throw std::runtime_error(std::string("Failed to open file: ") + argv[2]);
+        }
+        const std::string text = GenerateText(std::stoull(argv[3]), 2720);
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        return 0;
+    }
+
+    const Options opt = ParseOptions(argc, argv);
+    std::vector<Result> results;
+
+    for (const size_t size : TextSizes(opt)) {
+        const std::string text = GenerateText(size, opt.seed);
+        std::cerr << "text " << size << " bytes...\n";
+        RunSingleSuite(opt, text, results);
+        RunMultiSuite(opt, text, results);
+        RunSmallSetSuite(opt, text, results);
+        RunIndexSuite(opt, text, results);
+        RunApproxSuite(opt, text, results);
+        RunStreamSuite(opt, text, results);
+    }
+    // Компромисс памяти и скорости и обновления словаря меряются на самом большом тексте.
+    if (!TextSizes(opt).empty()) {
+        const std::string text = GenerateText(TextSizes(opt).back(), opt.seed);
+        RunLayoutSuite(opt, text, results);
+        RunUpdateSuite(opt, text, results);
+    }
+
+    if (opt.out.empty()) {
+        WriteJson(std::cout, opt, results);
+    } else {
+        std::ofstream file(opt.out);
+        if (!file) {
+            throw std::runtime_error("Failed to open output file: " + opt.out);
+        }
+        WriteJson(file, opt, results);
+    }
+    return 0;
+}
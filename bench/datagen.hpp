@@ -0,0 +1,87 @@
+// ============================================================================
+// Данный заголовочный файл содержит генератор синтетических данных в формате
+// data/data.txt: фамилия и имя, три числа, число и необязательное слово.
+// ============================================================================
+
+#ifndef DATAGEN_HPP
+#define DATAGEN_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Генератор детерминирован: одинаковые seed и размер дают одинаковый текст,
+// поэтому результаты бенчмарков можно сравнивать между запусками.
+
+// ======================================================
+// | GenerateLine(rng) | GenerateText(bytes, seed)      |
+// | SamplePatterns(text, count, length, seed)          |
+// ======================================================
+
+inline std::string GenerateLine(std::mt19937_64& rng) {
+    static const std::vector<std::string> surnames = {
+        "Иванов", "Петров", "Сидоров", "Щукин", "Яковлев", "Щербаков", "Юдин", "Кузнецов", "Smith", "Brown"};
+    static const std::vector<std::string> names = {
+        "Иван", "Пётр", "Ярослав", "Анна", "Мария", "Щедрослав", "John", "Olga"};
+    static const std::vector<std::string> extras = {"Я", "Щ", "4", "x2720", "628"};
+
+    auto pick = [&rng](const std::vector<std::string>& list) -> const std::string& {
+        return list[rng() % list.size()];
+    };
+
+    std::string line;
+    line += pick(surnames);
+    line += ' ';
+    line += pick(names);
+    for (int k = 0; k < 3; ++k) {
+        line += ' ';
+        line += std::to_string(rng() % 100000);
+    }
+    line += ' ';
+    line += std::to_string(rng() % 10000000);
+    if (rng() % 2 == 0) {
+        line += ' ';
+        line += pick(extras);
+    }
+    return line;
+}
+
+// Текст из целых строк общим размером не больше bytes: строка, которая не поместилась
+// целиком, отбрасывается, чтобы разбор не встретил неполную запись.
+inline std::string GenerateText(size_t bytes, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::string text;
+    text.reserve(bytes + 64);
+    while (text.size() < bytes) {
+        text += GenerateLine(rng);
+        text += '\n';
+    }
+    text.resize(bytes);
+    const size_t last = text.rfind('\n');
+    text.resize(last == std::string::npos ? 0 : last + 1);
+    return text;
+}
+
+// Шаблоны длины length: в основном подстроки текста (чтобы были совпадения),
+// каждый четвёртый — случайные цифры, которых в тексте может не оказаться.
+inline std::vector<std::string> SamplePatterns(const std::string& text, size_t count, size_t length, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> patterns;
+    patterns.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 4 == 3 || text.size() < length) {
+            std::string p;
+            for (size_t k = 0; k < length; ++k) {
+                p += static_cast<char>('0' + rng() % 10);
+            }
+            patterns.push_back(std::move(p));
+        } else {
+            patterns.push_back(text.substr(rng() % (text.size() - length + 1), length));
+        }
+    }
+    return patterns;
+}
+
+#endif // DATAGEN_HPP
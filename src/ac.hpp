@@ -8,181 +8,711 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <queue>
+#include <array>
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "casefold.hpp"
+#include "profile.hpp"
 
 // Логика алгоритма:
 // 1. Для всех шаблонов (patterns) строится префиксное дерево (trie).
 // 2. Для каждого узла trie вычисляется суффиксная ссылка.
 // 3. Также для ускорения переходов при обработке символов текста формируются связки go.
-// 4. Для быстрого обнаружения всех шаблонов, “оканчивающихся” в данном узле или 
+// 4. Для быстрого обнаружения всех шаблонов, “оканчивающихся” в данном узле или
 //    в его суффиксном предке, создадим конечную ссылку up.
 
+// Представление автомата:
+// Узлы trie нумеруются в порядке обхода в ширину (корень — 0), поэтому неглубокие
+// узлы имеют меньшие номера, а дети каждого узла идут подряд по возрастанию класса.
+// Байты, не встречающиеся ни в одном шаблоне, попадают в общий класс 0 — переход по
+// нему всегда ведёт в корень.
+//
+// Узлы [0, denseStates) плотные: для них переходы go хранятся в таблице uint32_t
+// (строка на узел, столбец на класс) и переход стоит одного чтения. Остальные узлы
+// разреженные: хранятся только рёбра trie (номер первого ребёнка и классы детей) и
+// суффиксная ссылка; переход ищет класс среди детей и при неудаче идёт по суффиксной
+// ссылке — она ведёт в менее глубокий узел и в конце концов в плотный.
+//
+// Число плотных узлов выбирается по бюджету памяти (memoryBudget): если полная
+// таблица помещается, все узлы плотные и поиск идёт как раньше; иначе плотными
+// становятся самые неглубокие узлы — через них проходит большая часть текста, —
+// а глубокие узлы словаря стоят по 12 байт. Занятая память — в stats().
+//
+// Весь автомат — несколько плоских массивов, и построение тоже обходится без таблицы
+// на все узлы: шаблоны сортируются, trie собирается одним проходом со стеком, а
+// таблица выделяется только под плотные узлы.
+
+// Поиск без учёта регистра (CaseMode::Insensitive):
+// Шаблоны сворачиваются в символы алфавита из casefold.hpp, и классы столбцов
+// строятся по символам, а не по байтам. Таблица byteClass тогда имеет три строки —
+// по одной на вид предыдущего байта, — и каждый байт текста по-прежнему читается
+// один раз: класс берётся из byteClass[row][byte], а переход — из go.
+
 // Сложность алгоритма:
-// Построение автомата: O(l), l - суммарная длина всех паттернов.
-// Поиск: O(n + k), где n - длина текста, k - количество найденных вхождений паттернов в тексте.
+// Построение автомата: O(l log m + d * σ), l - суммарная длина всех паттернов, m - их число,
+// d - число плотных узлов, σ - число классов символов.
+// Поиск: O(n + k), где n - длина текста, k - количество найденных вхождений паттернов в тексте
+// (переходы из разреженных узлов амортизированно тоже O(1) на байт, как в классическом AC).
 
 // ==================================================================
+// | AhoCorasick(vector<string> patterns).search(text, callback)    |
+// | AhoCorasick(vector<string> patterns).containsAll(text, count)  |
+// | AcStream(automaton).feed(chunk, callback)                      |
 // | AhoSearch (string text, vector<string> patterns, size_t count) |
 // ==================================================================
 
-struct Node {
-    std::unordered_map<char, std::unique_ptr<Node>> son;
-    // go: кэш (мемоизация) переходов по символам, когда мы уже знаем, куда идти.
-    std::unordered_map<char, Node*> go;
-    Node* parent = nullptr;
-    char charToParent = '\0';
-    Node* suffLink = nullptr;
-    Node* up = nullptr;
-    bool isTerminal = false;
-    // pattern_indices: индексы шаблонов, которые оканчиваются в данном узле.
-    std::vector<int> pattern_indices;
-
-    Node(Node* p = nullptr, char c = '\0') : parent(p), charToParent(c) {}
+// Бюджет памяти автомата по умолчанию (байт).
+inline constexpr size_t AC_DEFAULT_MEMORY_BUDGET = size_t{1} << 30;
+
+// AcMatch — одно вхождение: end — позиция сразу за последним байтом совпадения,
+// pattern — индекс шаблона. Начало вхождения: end - patternLength(pattern).
+struct AcMatch {
+    size_t end;
+    uint32_t pattern;
 };
 
-inline Node* createNode(Node* parent = nullptr, char c = '\0') {
-    return new Node(parent, c);
-}
+// AcCursor — положение автомата между частями текста: узел и вид предыдущего байта
+// (нужен только при поиске без учёта регистра).
+struct AcCursor {
+    uint32_t state = 0;
+    uint8_t row = 0;
+};
 
-static Node* root = nullptr;
+// Класс AhoCorasick компилирует набор шаблонов в автомат один раз и владеет его памятью
+// (или, если автомат загружен из файла, держит отображение этого файла).
+// После построения автомат не изменяется, поэтому константные методы поиска можно
+// вызывать одновременно из нескольких потоков.
+class AhoCorasick {
+public:
+    explicit AhoCorasick(const std::vector<std::string>& patterns, CaseMode mode = CaseMode::Sensitive,
+                         size_t memoryBudget = AC_DEFAULT_MEMORY_BUDGET)
+        : patternCount(patterns.size()), caseMode(mode) {
+        // Символы всех шаблонов лежат подряд в одном массиве: шаблон i занимает
+        // symbols[symbolBegin[i] .. symbolBegin[i + 1]).
+        size_t total = 0;
+        for (const auto& p : patterns) {
+            total += p.size();
+        }
+        std::vector<uint16_t> symbols;
+        symbols.reserve(total);
+        std::vector<size_t> symbolBegin;
+        symbolBegin.reserve(patterns.size() + 1);
+        symbolBegin.push_back(0);
+        patternLengths.reserve(patterns.size());
+        for (const auto& p : patterns) {
+            appendSymbols(symbols, p);
+            symbolBegin.push_back(symbols.size());
+            patternLengths.push_back(static_cast<uint32_t>(p.size()));
+        }
 
-inline void initTrie() {
-    root = createNode();
-}
+        buildClasses(symbols);
+        Trie trie = buildTrie(symbols, symbolBegin);
+        buildOutputs(trie);
+        buildAutomation(trie, memoryBudget);
+        bindImage();
+    }
+
+    // Автомат содержит указатели на собственные массивы, поэтому копирование запрещено.
+    // При перемещении буферы векторов сохраняются, но таблица byteClass лежит внутри
+    // объекта: построенный автомат заново направляет view в свои массивы. У
+    // загруженного автомата view указывает в память backing и остаётся верным.
+    AhoCorasick(const AhoCorasick&) = delete;
+    AhoCorasick& operator=(const AhoCorasick&) = delete;
 
-inline void addString(const std::string& word, size_t index) {
-    Node* cur = root;
-    for (const char c : word) {
-        auto& child = cur->son[c];
-        if (!child) {
-            child = std::make_unique<Node>(cur, c);
+    AhoCorasick(AhoCorasick&& other) noexcept { moveFrom(other); }
+
+    AhoCorasick& operator=(AhoCorasick&& other) noexcept {
+        if (this != &other) {
+            moveFrom(other);
         }
-        cur = child.get();
+        return *this;
     }
-    cur->isTerminal = true;
-    cur->pattern_indices.push_back(static_cast<int>(index));
-}
 
-static Node* getSuffLink(Node* v);
-static Node* getLink(Node* v, char c);
-static Node* getUp(Node* v);
+    // Image — всё, что нужно для поиска: плоские массивы uint32_t без указателей
+    // внутри. Построенный автомат указывает в свои векторы, загруженный из файла
+    // (см. acfile.hpp) — прямо в отображённую память.
+    struct Image {
+        CaseMode mode;
+        uint32_t classes;
+        size_t patterns;
+        size_t states;
+        size_t outputs;
+        size_t denseStates;
+        const uint32_t* byteClass;       // FOLD_ROWS * 256
+        const uint32_t* patternLengths;  // patterns
+        const uint32_t* go;              // denseStates * classes
+        const uint32_t* up;              // states
+        const uint32_t* outBegin;        // states + 1
+        const uint32_t* outPatterns;     // outputs
+        // Разреженные узлы v >= denseStates, индекс — v - denseStates:
+        const uint32_t* sparseFirst;     // states - denseStates + 1: номер первого ребёнка
+        const uint32_t* sparseClass;     // states - denseStates: класс ребра в узел
+        const uint32_t* sparseFail;      // states - denseStates: суффиксная ссылка
+    };
 
-inline static Node* getSuffLink(Node* v) {
-    if (!v->suffLink) {
-        if (v == root || v->parent == root) {
-            v->suffLink = root;
-        } else {
-            v->suffLink = getLink(getSuffLink(v->parent), v->charToParent);
+    // Автомат поверх готовых массивов; backing держит их память, пока жив автомат.
+    [[nodiscard]] static AhoCorasick fromImage(const Image& image, std::shared_ptr<const void> backing) {
+        return AhoCorasick(image, std::move(backing));
+    }
+
+    [[nodiscard]] const Image& image() const { return view; }
+
+    [[nodiscard]] size_t size() const { return patternCount; }
+    [[nodiscard]] size_t stateCount() const { return view.states; }
+    [[nodiscard]] size_t denseStateCount() const { return view.denseStates; }
+    [[nodiscard]] size_t classCount() const { return classes; }
+    [[nodiscard]] size_t patternLength(size_t index) const { return view.patternLengths[index]; }
+    [[nodiscard]] CaseMode mode() const { return caseMode; }
+
+    // Статистика построенного автомата: число узлов и занятая память по массивам.
+    struct Stats {
+        size_t states;
+        size_t denseStates;
+        size_t classes;
+        size_t patterns;
+        size_t outputs;
+        size_t tableBytes;   // таблица переходов go плотных узлов
+        size_t sparseBytes;  // рёбра и суффиксные ссылки разреженных узлов
+        size_t linkBytes;    // конечные ссылки up
+        size_t outputBytes;  // outBegin, outPatterns и длины шаблонов
+        size_t totalBytes;   // всё вместе с таблицами классов
+        double bytesPerPattern;
+    };
+
+    [[nodiscard]] Stats stats() const {
+        Stats st{};
+        const size_t sparse = view.states - view.denseStates;
+        st.states = view.states;
+        st.denseStates = view.denseStates;
+        st.classes = classes;
+        st.patterns = patternCount;
+        st.outputs = view.outputs;
+        st.tableBytes = view.denseStates * classes * sizeof(uint32_t);
+        st.sparseBytes = (3 * sparse + 1) * sizeof(uint32_t);
+        st.linkBytes = view.states * sizeof(uint32_t);
+        st.outputBytes = (view.states + 1 + view.outputs + patternCount) * sizeof(uint32_t);
+        st.totalBytes = sizeof(*this) + st.tableBytes + st.sparseBytes + st.linkBytes + st.outputBytes;
+        st.bytesPerPattern = patternCount ? static_cast<double>(st.totalBytes) / static_cast<double>(patternCount) : 0.0;
+        return st;
+    }
+
+    // Передаёт каждое вхождение в callback(end, pattern) в порядке возрастания end;
+    // шаблоны, оканчивающиеся в одной позиции, идут от длинных к коротким.
+    // Если callback возвращает bool, значение false прекращает поиск.
+    // Возвращает false, если поиск был прерван.
+    template <typename Callback>
+    bool search(std::string_view text, Callback&& callback) const {
+        AcCursor cursor;
+        return searchFrom(cursor, text, callback);
+    }
+
+    // То же, но автомат стартует из положения cursor и оставляет в нём положение после
+    // последнего прочитанного байта. Так текст можно подавать по частям (см. AcStream).
+    template <typename Callback>
+    bool searchFrom(AcCursor& cursor, std::string_view text, Callback&& callback) const {
+        const bool sparse = view.denseStates != view.states;
+        if (caseMode == CaseMode::Insensitive) {
+            return sparse ? scan<true, true>(cursor, text, callback) : scan<true, false>(cursor, text, callback);
         }
+        return sparse ? scan<false, true>(cursor, text, callback) : scan<false, false>(cursor, text, callback);
     }
-    return v->suffLink;
-}
 
-inline static Node* getLink(Node* v, char c) {
-    auto it = v->go.find(c);
-    if (it == v->go.end()) {
-        if (v->son.count(c)) {
-            v->go[c] = v->son[c].get();
-        } else {
-            v->go[c] = (v == root) ? root : getLink(getSuffLink(v), c);
+    // Записывает все вхождения в переиспользуемый вектор out (старое содержимое удаляется).
+    void search(std::string_view text, std::vector<AcMatch>& out) const {
+        out.clear();
+        search(text, [&out](size_t end, uint32_t pattern) {
+            out.push_back(AcMatch{end, pattern});
+        });
+    }
+
+    // Возвращает true, если в тексте встретились все шаблоны с индексами меньше count.
+    // Найденные шаблоны отмечаются битами: до 64 шаблонов — в одном слове на стеке,
+    // для больших наборов — в буфере seen, который вызывающий переиспользует между
+    // вызовами. Память при поиске не выделяется.
+    [[nodiscard]] bool containsAll(std::string_view text, size_t count, std::vector<uint64_t>& seen) const {
+        if (count == 0) {
+            return true;
         }
+        uint64_t small = 0;
+        uint64_t* found = &small;
+        if (count > 64) {
+            seen.assign((count + 63) / 64, 0);
+            found = seen.data();
+        }
+        size_t found_count = 0;
+
+        search(text, [&](size_t, uint32_t index) {
+            const uint64_t bit = uint64_t{1} << (index & 63);
+            if (index < count && (found[index >> 6] & bit) == 0) {
+                found[index >> 6] |= bit;
+                ++found_count;
+            }
+            return found_count != count;
+        });
+        return found_count == count;
     }
-    return v->go[c];
-}
 
-inline static Node* getUp(Node* v) {
-    if (!v->up) {
-        Node* sufflink = getSuffLink(v);
-        v->up = (sufflink->isTerminal) 
-                    ? sufflink 
-                    : ((sufflink == root) ? root : getUp(sufflink));
+    // То же без буфера вызывающего: для наборов больше 64 шаблонов он выделяется
+    // на каждый вызов.
+    [[nodiscard]] bool containsAll(std::string_view text, size_t count) const {
+        std::vector<uint64_t> seen;
+        return containsAll(text, count, seen);
     }
-    return v->up;
-}
 
-inline void buildAutomation(const std::vector<std::string>& patterns) {
-    initTrie();
+    [[nodiscard]] bool containsAll(std::string_view text, std::vector<uint64_t>& seen) const {
+        return containsAll(text, patternCount, seen);
+    }
 
-    for (size_t i = 0; i < patterns.size(); ++i) {
-        addString(patterns[i], i);
+    [[nodiscard]] bool containsAll(std::string_view text) const {
+        return containsAll(text, patternCount);
     }
 
-    // Очередь для обхода в ширину (BFS) по trie.
-    std::queue<Node*> q;
-    root->suffLink = root;
+private:
+    // Среди стольких детей класс ищется перебором, среди большего числа — бинарным поиском.
+    static constexpr uint32_t LINEAR_CHILDREN = 8;
+    static constexpr uint32_t NO_CHILD = UINT32_MAX;
 
-    for (auto& child : root->son) {
-        child.second->suffLink = root;
-        q.push(child.second.get());
+    size_t patternCount = 0;
+    std::vector<uint32_t> patternLengths;
+    CaseMode caseMode = CaseMode::Sensitive;
+    // byteClass: номер столбца таблицы переходов для каждого байта; при поиске без
+    // учёта регистра — для каждой пары (вид предыдущего байта, байт).
+    std::array<uint32_t, FOLD_ROWS * 256> byteClass{};
+    // symbolClass: номер столбца для символа шаблона (без свёртки символ — байт).
+    std::array<uint32_t, FOLD_SYMBOLS> symbolClass{};
+    uint32_t classes = 1;
+    // go: плотная таблица переходов размером denseStateCount() * classes.
+    std::vector<uint32_t> go;
+    // up: ближайший по суффиксным ссылкам терминальный узел (0 — такого нет).
+    std::vector<uint32_t> up;
+    // Шаблоны, оканчивающиеся в узле v, лежат в outPatterns[outBegin[v] .. outBegin[v + 1]).
+    std::vector<uint32_t> outBegin;
+    std::vector<uint32_t> outPatterns;
+    // Рёбра и суффиксные ссылки разреженных узлов (см. Image).
+    std::vector<uint32_t> sparseFirst;
+    std::vector<uint32_t> sparseClass;
+    std::vector<uint32_t> sparseFail;
+    // view — массивы, по которым идёт поиск; backing держит чужую память (файл).
+    Image view{};
+    std::shared_ptr<const void> backing;
+
+    // Trie в порядке обхода в ширину; нужен только во время построения.
+    // Дети узла v — узлы [firstChild[v], firstChild[v + 1]), inClass[u] — класс ребра
+    // в узел u, terminal[i] — узел, в котором оканчивается шаблон i.
+    struct Trie {
+        std::vector<uint32_t> firstChild;
+        std::vector<uint32_t> parent;
+        std::vector<uint32_t> inClass;
+        std::vector<uint32_t> terminal;
+
+        [[nodiscard]] size_t size() const { return parent.size(); }
+    };
+
+    AhoCorasick(const Image& image, std::shared_ptr<const void> memory)
+        : patternCount(image.patterns), caseMode(image.mode), classes(image.classes),
+          view(image), backing(std::move(memory)) {}
+
+    // Ищет ребёнка узла по классу среди отсортированных классов детей [first, last).
+    // Возвращает номер ребёнка или NO_CHILD, если ребра нет.
+    [[nodiscard]] static uint32_t findChild(const uint32_t* classOf, uint32_t first, uint32_t last, uint32_t c) {
+        if (last - first <= LINEAR_CHILDREN) {
+            for (uint32_t u = first; u < last; ++u) {
+                if (classOf[u] == c) {
+                    return u;
+                }
+            }
+            return NO_CHILD;
+        }
+        const uint32_t* it = std::lower_bound(classOf + first, classOf + last, c);
+        return (it != classOf + last && *it == c) ? static_cast<uint32_t>(it - classOf) : NO_CHILD;
     }
 
-    while (!q.empty()) {
-        Node* cur = q.front();
-        q.pop();
+    // Переход из узла state по классу c: разреженные узлы проверяют своих детей
+    // и уступают суффиксной ссылке, плотные читают таблицу.
+    [[nodiscard]] uint32_t step(uint32_t state, uint32_t c) const {
+        // Дети разреженного узла тоже разреженные, поэтому все номера сдвинуты на dense.
+        const auto dense = static_cast<uint32_t>(view.denseStates);
+        while (state >= dense) {
+            const size_t k = state - dense;
+            const uint32_t child = findChild(view.sparseClass, view.sparseFirst[k] - dense,
+                                             view.sparseFirst[k + 1] - dense, c);
+            if (child != NO_CHILD) {
+                return child + dense;
+            }
+            state = view.sparseFail[k];
+            LAB_COUNT(FailureSteps, 1);
+        }
+        return view.go[static_cast<size_t>(state) * classes + c];
+    }
 
-        for (auto& child : cur->son) {
-            char c = child.first;
-            Node* node = child.second.get();
-            Node* f = cur->suffLink;
+    template <bool Fold, bool Sparse, typename Callback>
+    bool scan(AcCursor& cursor, std::string_view text, Callback& callback) const {
+        const uint32_t* const table = view.go;
+        const uint32_t* const cls = view.byteClass;
+        const uint32_t* const links = view.up;
+        const uint32_t* const outs = view.outBegin;
+        const size_t width = classes;
 
-            while (f != root && f->son.find(c) == f->son.end()) {
-                f = f->suffLink;
+        uint32_t cur = cursor.state;
+        uint8_t row = cursor.row;
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            const auto b = static_cast<unsigned char>(text[pos]);
+            uint32_t c;
+            if constexpr (Fold) {
+                c = cls[row * 256 + b];
+                row = CaseFoldRow(b);
+            } else {
+                c = cls[b];
             }
-            if (f->son.find(c) != f->son.end()) {
-                node->suffLink = f->son[c].get();
+            if constexpr (Sparse) {
+                cur = step(cur, c);
             } else {
-                node->suffLink = root;
+                cur = table[static_cast<size_t>(cur) * width + c];
+            }
+            LAB_COUNT(StateTransitions, 1);
+
+            uint32_t temp = outs[cur] != outs[cur + 1] ? cur : links[cur];
+            while (temp != 0) {
+                LAB_COUNT(OutputWalks, 1);
+                for (uint32_t k = outs[temp]; k < outs[temp + 1]; ++k) {
+                    if (!emit(callback, pos + 1, view.outPatterns[k])) {
+                        cursor = AcCursor{cur, row};
+                        LAB_COUNT(BytesScanned, pos + 1);
+                        return false;
+                    }
+                }
+                temp = links[temp];
+            }
+        }
+        cursor = AcCursor{cur, row};
+        LAB_COUNT(BytesScanned, text.size());
+        return true;
+    }
+
+    // Дописывает символы шаблона в общий массив (без свёртки символ — это сам байт).
+    void appendSymbols(std::vector<uint16_t>& symbols, const std::string& pattern) const {
+        if (caseMode == CaseMode::Insensitive) {
+            const auto& fold = CaseFoldTable();
+            uint8_t row = 0;
+            for (const char c : pattern) {
+                const auto b = static_cast<unsigned char>(c);
+                symbols.push_back(fold[row * 256 + b]);
+                row = CaseFoldRow(b);
             }
-            q.push(node);
+        } else {
+            symbols.insert(symbols.end(), reinterpret_cast<const unsigned char*>(pattern.data()),
+                           reinterpret_cast<const unsigned char*>(pattern.data()) + pattern.size());
         }
+    }
 
-        cur->up = (cur->suffLink->isTerminal) ? cur->suffLink : cur->suffLink->up;
+    template <typename Callback>
+    static bool emit(Callback& callback, size_t end, uint32_t pattern) {
+        LAB_COUNT(Matches, 1);
+        if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t, uint32_t>, bool>) {
+            return callback(end, pattern);
+        } else {
+            callback(end, pattern);
+            return true;
+        }
     }
-}
 
-// Функция AhoSearch ищет все паттерны (patterns) в тексте (text). 
-// Возвращает true, если найдены все шаблоны, иначе — false.
-// Параметр count указывает, сколько шаблонов требуется найти.
-// (Если каждый шаблон нужно найти хотя бы один раз.)
-[[nodiscard]] bool AhoSearch(const std::string& text, const std::vector<std::string>& patterns, size_t count) {
-    buildAutomation(patterns);
-
-    std::vector<bool> found(count, false);
-    size_t found_count = 0;
-
-    Node* cur = root;
-    for (const char& c : text) {
-        cur = getLink(cur, c);
-
-        Node* temp = cur;
-        while (temp != root) {
-            if (temp->isTerminal) {
-                for (size_t index : temp->pattern_indices) {
-                    if (index < count && !found[index]) {
-                        found[index] = true;
-                        ++found_count;
-                        if (found_count == count) {
-                            return true;
-                        }
-                    }
+    // Классы строятся по символам шаблонов; без свёртки символ — это сам байт.
+    // Номера классов возрастают вместе с символами, поэтому порядок детей по символу
+    // совпадает с порядком по классу.
+    void buildClasses(const std::vector<uint16_t>& symbols) {
+        for (const uint16_t sym : symbols) {
+            symbolClass[sym] = 1;
+        }
+        for (auto& cls : symbolClass) {
+            cls = cls ? classes++ : 0;
+        }
+
+        if (caseMode == CaseMode::Insensitive) {
+            const auto& fold = CaseFoldTable();
+            for (size_t k = 0; k < fold.size(); ++k) {
+                byteClass[k] = symbolClass[fold[k]];
+            }
+        } else {
+            for (size_t b = 0; b < 256; ++b) {
+                byteClass[b] = symbolClass[b];
+            }
+        }
+    }
+
+    // Шаблоны сортируются по символам, и trie собирается одним проходом: у соседних
+    // шаблонов общий префикс уже есть на стеке пути, новые узлы создаются только для
+    // остатка. Дети каждого узла при этом появляются по возрастанию класса. Затем узлы
+    // перенумеровываются обходом в ширину.
+    Trie buildTrie(const std::vector<uint16_t>& symbols, const std::vector<size_t>& symbolBegin) const {
+        const size_t count = patternLengths.size();
+        auto word = [&](uint32_t i) { return symbols.data() + symbolBegin[i]; };
+        auto length = [&](uint32_t i) { return symbolBegin[i + 1] - symbolBegin[i]; };
+
+        std::vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return std::lexicographical_compare(word(a), word(a) + length(a), word(b), word(b) + length(b));
+        });
+
+        // Узлы в порядке создания: родитель и класс ребра; корень — узел 0.
+        std::vector<uint32_t> parent(1, 0);
+        std::vector<uint32_t> inClass(1, 0);
+        std::vector<uint32_t> terminal(count, 0);
+        parent.reserve(symbols.size() + 1);
+        inClass.reserve(symbols.size() + 1);
+        std::vector<uint32_t> path(1, 0);  // path[d] — узел на глубине d текущего шаблона
+
+        for (size_t k = 0; k < count; ++k) {
+            const uint32_t i = order[k];
+            const uint16_t* w = word(i);
+            const size_t n = length(i);
+            size_t common = 0;
+            if (k > 0) {
+                const uint32_t p = order[k - 1];
+                const size_t limit = std::min(n, length(p));
+                while (common < limit && word(p)[common] == w[common]) {
+                    ++common;
+                }
+            }
+            path.resize(common + 1);
+            for (size_t d = common; d < n; ++d) {
+                if (parent.size() > UINT32_MAX - 1) {
+                    throw std::length_error("AhoCorasick: too many states");
                 }
+                parent.push_back(path[d]);
+                inClass.push_back(symbolClass[w[d]]);
+                path.push_back(static_cast<uint32_t>(parent.size() - 1));
+            }
+            terminal[i] = path[n];
+        }
+
+        // Дети каждого узла подряд (сортировка подсчётом по родителю сохраняет порядок создания).
+        const size_t states = parent.size();
+        std::vector<uint32_t> childBegin(states + 1, 0);
+        for (size_t u = 1; u < states; ++u) {
+            ++childBegin[parent[u] + 1];
+        }
+        for (size_t v = 0; v < states; ++v) {
+            childBegin[v + 1] += childBegin[v];
+        }
+        std::vector<uint32_t> children(states > 0 ? states - 1 : 0);
+        {
+            std::vector<uint32_t> fill(childBegin.begin(), childBegin.end() - 1);
+            for (size_t u = 1; u < states; ++u) {
+                children[fill[parent[u]]++] = static_cast<uint32_t>(u);
             }
-            temp = getUp(temp);
         }
+
+        // Обход в ширину: узел получает номер при постановке в очередь, поэтому дети
+        // одного узла получают подряд идущие номера, а номер первого ребёнка растёт
+        // вместе с номером родителя.
+        Trie trie;
+        trie.firstChild.resize(states + 1);
+        trie.parent.resize(states);
+        trie.inClass.resize(states);
+        std::vector<uint32_t> renumber(states);
+        std::vector<uint32_t> queue;  // старые номера в порядке новых
+        queue.reserve(states);
+        queue.push_back(0);
+        renumber[0] = 0;
+        trie.parent[0] = 0;
+        trie.inClass[0] = 0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            const uint32_t old = queue[head];
+            trie.firstChild[head] = static_cast<uint32_t>(queue.size());
+            for (uint32_t k = childBegin[old]; k < childBegin[old + 1]; ++k) {
+                const uint32_t child = children[k];
+                const auto id = static_cast<uint32_t>(queue.size());
+                renumber[child] = id;
+                trie.parent[id] = static_cast<uint32_t>(head);
+                trie.inClass[id] = inClass[child];
+                queue.push_back(child);
+            }
+        }
+        trie.firstChild[states] = static_cast<uint32_t>(states);
+
+        trie.terminal.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            trie.terminal[i] = renumber[terminal[i]];
+        }
+        return trie;
     }
-    return found_count == count;
-}
 
-inline void deleteTrie(Node* node) {
-    if (node) {
-        for (auto& child : node->son) {
-            deleteTrie(child.second.release());
+    // Раскладываем шаблоны по узлам подсчётом, сохраняя порядок индексов.
+    void buildOutputs(const Trie& trie) {
+        const size_t states = trie.size();
+        outBegin.assign(states + 1, 0);
+        for (const uint32_t state : trie.terminal) {
+            ++outBegin[state + 1];
+        }
+        for (size_t v = 0; v < states; ++v) {
+            outBegin[v + 1] += outBegin[v];
+        }
+        outPatterns.resize(trie.terminal.size());
+        std::vector<uint32_t> fill(outBegin.begin(), outBegin.end() - 1);
+        for (size_t i = 0; i < trie.terminal.size(); ++i) {
+            outPatterns[fill[trie.terminal[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    [[nodiscard]] bool isTerminal(uint32_t state) const {
+        return outBegin[state] != outBegin[state + 1];
+    }
+
+    // Сколько узлов сделать плотными, чтобы автомат уложился в budget байт. Плотный
+    // узел стоит classes * 4 байт, разреженный — 12 (первый ребёнок, класс, ссылка);
+    // up, outBegin, outPatterns и длины шаблонов нужны при любом выборе.
+    [[nodiscard]] size_t chooseDenseStates(size_t states, size_t budget) const {
+        const size_t denseCost = size_t{classes} * sizeof(uint32_t);
+        const size_t sparseCost = 3 * sizeof(uint32_t);
+        if (denseCost <= sparseCost) {
+            return states;
+        }
+        const size_t fixed = sizeof(*this) + (2 * states + 2 + outPatterns.size() + patternLengths.size()) * sizeof(uint32_t) +
+                             states * sparseCost;
+        if (budget <= fixed) {
+            return 1;
+        }
+        return std::clamp<size_t>((budget - fixed) / (denseCost - sparseCost), 1, states);
+    }
+
+    // Узлы обрабатываются в порядке номеров, то есть по неубыванию глубины: суффиксная
+    // ссылка и её строка таблицы к этому моменту уже готовы. Строка плотного узла —
+    // копия строки его суффиксной ссылки, поверх которой записаны рёбра trie.
+    void buildAutomation(const Trie& trie, size_t memoryBudget) {
+        const size_t states = trie.size();
+        const size_t dense = chooseDenseStates(states, memoryBudget);
+        const size_t width = classes;
+
+        go.assign(dense * width, 0);
+        up.assign(states, 0);
+        std::vector<uint32_t> fail(states, 0);
+
+        // Переход по классу c с учётом суффиксных ссылок (для уже обработанных узлов).
+        auto delta = [&](uint32_t state, uint32_t c) {
+            while (state >= dense) {
+                const uint32_t child = findChild(trie.inClass.data(), trie.firstChild[state],
+                                                 trie.firstChild[state + 1], c);
+                if (child != NO_CHILD) {
+                    return child;
+                }
+                state = fail[state];
+            }
+            return go[static_cast<size_t>(state) * width + c];
+        };
+
+        for (size_t v = 0; v < states; ++v) {
+            if (v != 0) {
+                const uint32_t p = trie.parent[v];
+                const uint32_t link = (p == 0) ? 0 : delta(fail[p], trie.inClass[v]);
+                fail[v] = link;
+                up[v] = isTerminal(link) ? link : up[link];
+            }
+            if (v < dense) {
+                uint32_t* row = go.data() + v * width;
+                if (v != 0) {
+                    const uint32_t* linkRow = go.data() + static_cast<size_t>(fail[v]) * width;
+                    std::copy(linkRow, linkRow + width, row);
+                }
+                for (uint32_t u = trie.firstChild[v]; u < trie.firstChild[v + 1]; ++u) {
+                    row[trie.inClass[u]] = u;
+                }
+            }
+        }
+
+        sparseFirst.assign(trie.firstChild.begin() + static_cast<std::ptrdiff_t>(dense), trie.firstChild.end());
+        sparseClass.assign(trie.inClass.begin() + static_cast<std::ptrdiff_t>(dense), trie.inClass.end());
+        sparseFail.assign(fail.begin() + static_cast<std::ptrdiff_t>(dense), fail.end());
+    }
+
+    void moveFrom(AhoCorasick& other) noexcept {
+        patternCount = other.patternCount;
+        patternLengths = std::move(other.patternLengths);
+        caseMode = other.caseMode;
+        byteClass = other.byteClass;
+        symbolClass = other.symbolClass;
+        classes = other.classes;
+        go = std::move(other.go);
+        up = std::move(other.up);
+        outBegin = std::move(other.outBegin);
+        outPatterns = std::move(other.outPatterns);
+        sparseFirst = std::move(other.sparseFirst);
+        sparseClass = std::move(other.sparseClass);
+        sparseFail = std::move(other.sparseFail);
+        view = other.view;
+        backing = std::move(other.backing);
+        if (!backing) {
+            bindImage();
         }
-        delete node;
     }
+
+    void bindImage() {
+        view = Image{caseMode, classes, patternCount, up.size(), outPatterns.size(), go.size() / classes,
+                     byteClass.data(), patternLengths.data(), go.data(), up.data(),
+                     outBegin.data(), outPatterns.data(),
+                     sparseFirst.data(), sparseClass.data(), sparseFail.data()};
+    }
+};
+
+// Класс AcStream — возобновляемый поиск по тексту, который поступает частями.
+// Между вызовами feed хранится только текущее положение автомата и число уже
+// прочитанных байт, поэтому вхождения на стыке частей находятся, а callback
+// получает глобальную позицию конца вхождения (uint64_t — тексты больше 4 ГБ).
+class AcStream {
+public:
+    explicit AcStream(const AhoCorasick& automaton) : ac(&automaton) {}
+
+    // Возвращает false, если callback остановил поиск.
+    template <typename Callback>
+    bool feed(std::string_view chunk, Callback&& callback) {
+        const uint64_t base = offset;
+        uint64_t stoppedAt = base + chunk.size();
+        const bool completed = ac->searchFrom(cursor, chunk, [&](size_t end, uint32_t pattern) {
+            if constexpr (std::is_same_v<std::invoke_result_t<Callback&, uint64_t, uint32_t>, bool>) {
+                if (!callback(base + end, pattern)) {
+                    stoppedAt = base + end;
+                    return false;
+                }
+                return true;
+            } else {
+                callback(base + end, pattern);
+                return true;
+            }
+        });
+        // При остановке положение и счётчик соответствуют байту, на котором остановились.
+        offset = stoppedAt;
+        return completed;
+    }
+
+    void reset() {
+        cursor = AcCursor{};
+        offset = 0;
+    }
+
+    [[nodiscard]] uint64_t consumed() const { return offset; }
+
+private:
+    const AhoCorasick* ac;
+    AcCursor cursor;
+    uint64_t offset = 0;
+};
+
+// Функция AhoSearch ищет все паттерны (patterns) в тексте (text).
+// Возвращает true, если найдены все шаблоны, иначе — false.
+// Параметр count указывает, сколько шаблонов требуется найти.
+// (Если каждый шаблон нужно найти хотя бы один раз.)
+// Автомат строится при каждом вызове; при поиске по многим текстам лучше один раз
+// создать AhoCorasick и переиспользовать его.
+[[nodiscard]] inline bool AhoSearch(const std::string& text, const std::vector<std::string>& patterns, size_t count) {
+    return AhoCorasick(patterns).containsAll(text, count);
 }
 
-#endif // AC_HPP
\ No newline at end of file
+#endif // AC_HPP
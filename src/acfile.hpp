@@ -0,0 +1,181 @@
+// ============================================================================
+// Данный заголовочный файл содержит двоичный формат скомпилированного автомата
+// Ахо–Корасик: запись в файл и загрузку через отображение в память (mmap).
+// ============================================================================
+
+#ifndef ACFILE_HPP
+#define ACFILE_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "ac.hpp"
+#include "file.hpp"
+
+// Формат файла (версия 1):
+// 1. Заголовок AcFileHeader (первые AC_FILE_HEADER_SPACE байт): сигнатура, версия,
+//    метка порядка байт, режим регистра, число классов, шаблонов, узлов, выходов и
+//    плотных узлов, затем смещения и длины секций от начала файла.
+// 2. Секции — массивы uint32_t из AhoCorasick::Image в порядке: byteClass,
+//    patternLengths, go, up, outBegin, outPatterns, sparseFirst, sparseClass,
+//    sparseFail. Каждая начинается с адреса, кратного AC_FILE_ALIGN.
+//
+// В секциях нет указателей — только номера узлов и индексы, поэтому файл не зависит
+// от адреса загрузки. LoadAutomaton отображает файл и направляет Image прямо в
+// отображение: ни разбора, ни копирования, ни пересчёта ссылок. Отображение только
+// для чтения, так что несколько процессов, загрузивших один файл, делят одни и те же
+// страницы кэша.
+//
+// Проверяются заголовок и границы секций; содержимое таблиц не проверяется —
+// файл должен быть записан SaveAutomaton той же версии.
+
+// ===========================================================
+// | SaveAutomaton(ac, path) | LoadAutomaton(path) -> AhoCorasick |
+// ===========================================================
+
+inline constexpr char AC_FILE_MAGIC[8] = {'L', 'A', 'B', 'A', 'C', 'A', 'U', 'T'};
+inline constexpr uint32_t AC_FILE_VERSION = 1;
+inline constexpr uint32_t AC_FILE_BYTE_ORDER = 0x01020304;
+inline constexpr size_t AC_FILE_ALIGN = 64;
+inline constexpr size_t AC_FILE_HEADER_SPACE = 256;
+inline constexpr size_t AC_FILE_SECTIONS = 9;
+
+struct AcFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t mode;
+    uint32_t classes;
+    uint64_t patterns;
+    uint64_t states;
+    uint64_t outputs;
+    uint64_t denseStates;
+    // Смещение от начала файла и число элементов uint32_t каждой секции.
+    uint64_t offset[AC_FILE_SECTIONS];
+    uint32_t count[AC_FILE_SECTIONS];
+};
+
+static_assert(sizeof(AcFileHeader) <= AC_FILE_HEADER_SPACE, "AcFileHeader must fit into its reserved space");
+
+// Число элементов каждой секции по параметрам автомата.
+[[nodiscard]] inline std::array<uint64_t, AC_FILE_SECTIONS> AcFileSectionCounts(const AhoCorasick::Image& image) {
+    const uint64_t sparse = image.states - image.denseStates;
+    return {FOLD_ROWS * 256, image.patterns, uint64_t{image.denseStates} * image.classes,
+            image.states, image.states + 1, image.outputs, sparse + 1, sparse, sparse};
+}
+
+inline void SaveAutomaton(const AhoCorasick& ac, const std::string& path) {
+    const AhoCorasick::Image& image = ac.image();
+    const std::array<const uint32_t*, AC_FILE_SECTIONS> data = {
+        image.byteClass, image.patternLengths, image.go, image.up, image.outBegin, image.outPatterns,
+        image.sparseFirst, image.sparseClass, image.sparseFail};
+    const auto counts = AcFileSectionCounts(image);
+
+    AcFileHeader header{};
+    std::memcpy(header.magic, AC_FILE_MAGIC, sizeof(header.magic));
+    header.version = AC_FILE_VERSION;
+    header.byteOrder = AC_FILE_BYTE_ORDER;
+    header.mode = static_cast<uint32_t>(image.mode);
+    header.classes = image.classes;
+    header.patterns = image.patterns;
+    header.states = image.states;
+    header.outputs = image.outputs;
+    header.denseStates = image.denseStates;
+
+    uint64_t pos = AC_FILE_HEADER_SPACE;
+    for (size_t k = 0; k < AC_FILE_SECTIONS; ++k) {
+        if (counts[k] > UINT32_MAX) {
+            throw std::length_error("SaveAutomaton: automaton is too large");
+        }
+        header.offset[k] = pos;
+        header.count[k] = static_cast<uint32_t>(counts[k]);
+        pos += counts[k] * sizeof(uint32_t);
+        pos = (pos + AC_FILE_ALIGN - 1) / AC_FILE_ALIGN * AC_FILE_ALIGN;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open automaton file: " + path);
+    }
+    static const char zeros[AC_FILE_HEADER_SPACE] = {};
+    uint64_t written = 0;
+    auto pad = [&](uint64_t to) {
+        file.write(zeros, static_cast<std::streamsize>(to - written));
+        written = to;
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    written = sizeof(header);
+    for (size_t k = 0; k < AC_FILE_SECTIONS; ++k) {
+        pad(header.offset[k]);
+        const uint64_t bytes = counts[k] * sizeof(uint32_t);
+        file.write(reinterpret_cast<const char*>(data[k]), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    }
+    pad(pos);
+    if (!file) {
+        throw std::runtime_error("Failed to write automaton file: " + path);
+    }
+}
+
+[[nodiscard]] inline AhoCorasick LoadAutomaton(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    const std::string_view bytes = file->view();
+
+    AcFileHeader header;
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error("Invalid automaton file: " + path);
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, AC_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Invalid automaton file: " + path);
+    }
+    if (header.version != AC_FILE_VERSION) {
+        throw std::runtime_error("Unsupported automaton file version: " + std::to_string(header.version));
+    }
+    if (header.byteOrder != AC_FILE_BYTE_ORDER) {
+        throw std::runtime_error("Automaton file has a different byte order: " + path);
+    }
+    if (header.mode > static_cast<uint32_t>(CaseMode::Insensitive) || header.classes == 0 || header.states == 0 ||
+        header.denseStates == 0 || header.denseStates > header.states) {
+        throw std::runtime_error("Invalid automaton file: " + path);
+    }
+
+    AhoCorasick::Image image{};
+    image.mode = static_cast<CaseMode>(header.mode);
+    image.classes = header.classes;
+    image.patterns = header.patterns;
+    image.states = header.states;
+    image.outputs = header.outputs;
+    image.denseStates = header.denseStates;
+
+    const auto counts = AcFileSectionCounts(image);
+    std::array<const uint32_t*, AC_FILE_SECTIONS> data{};
+    for (size_t k = 0; k < AC_FILE_SECTIONS; ++k) {
+        if (header.count[k] != counts[k] || header.offset[k] % AC_FILE_ALIGN != 0 ||
+            header.offset[k] > bytes.size() || counts[k] > (bytes.size() - header.offset[k]) / sizeof(uint32_t)) {
+            throw std::runtime_error("Invalid automaton file: " + path);
+        }
+        data[k] = reinterpret_cast<const uint32_t*>(bytes.data() + header.offset[k]);
+    }
+    image.byteClass = data[0];
+    image.patternLengths = data[1];
+    image.go = data[2];
+    image.up = data[3];
+    image.outBegin = data[4];
+    image.outPatterns = data[5];
+    image.sparseFirst = data[6];
+    image.sparseClass = data[7];
+    image.sparseFail = data[8];
+    if (image.outBegin[image.states] != image.outputs) {
+        throw std::runtime_error("Invalid automaton file: " + path);
+    }
+
+    return AhoCorasick::fromImage(image, std::move(file));
+}
+
+#endif // ACFILE_HPP
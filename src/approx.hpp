@@ -0,0 +1,253 @@
+// ============================================================================
+// Данный заголовочный файл содержит приближённый поиск одного шаблона: не больше
+// k замен (Bitap) или не больше k правок (битовые векторы Майерса).
+// ============================================================================
+
+#ifndef APPROX_HPP
+#define APPROX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "casefold.hpp"
+#include "profile.hpp"
+
+// Метрики:
+// 1. Hamming — окно текста длины m, отличающееся от шаблона не больше чем в k байтах
+//    (опечатки и шум OCR, не меняющие длину: "2720" ~ "2726").
+// 2. Levenshtein — подстрока текста, из которой шаблон получается не больше чем за
+//    k вставок, удалений и замен байт ("2720" ~ "272" ~ "27200").
+//
+// Движки (шаблон до APPROX_MAX_PATTERN = 64 байт, бит i слова — байт шаблона i):
+// 1. Bitap (Hamming, форма Shift-And) — k + 1 слов состояния: бит i слова j
+//    установлен, если первые i + 1 байт шаблона совпадают с текстом, оканчивающимся
+//    в текущей позиции, не больше чем с j заменами:
+//      S0' = ((S0 << 1) | 1) & Eq[c],
+//      Sj' = (((Sj << 1) | 1) & Eq[c]) | (S(j-1) << 1) | 1,
+//    где Eq[c] — биты позиций шаблона, равных байту c. Вхождение с расстоянием j —
+//    старший бит шаблона в Sj. O(k) операций над словом на байт текста.
+// 2. Myers (Levenshtein) — столбец таблицы динамического программирования хранится
+//    разностями соседних клеток (Pv/Mv: +1/-1 по вертикали), и весь столбец
+//    пересчитывается за ~15 операций над словом на байт текста независимо от k;
+//    счёт последней строки — расстояние лучшего вхождения, оканчивающегося здесь.
+//
+// Оба движка сообщают callback(end, distance): end — позиция сразу за последним
+// байтом вхождения (как у AhoCorasick), distance — наименьшее расстояние среди
+// вхождений, оканчивающихся в end. Позиции идут по возрастанию; для Levenshtein
+// одно «место» опечатки обычно даёт несколько соседних end. Расстояние считается в
+// байтах: замена кириллической буквы на другую — одна или две правки.
+//
+// Без учёта регистра текст читается символами свёртки (casefold.hpp): таблица Eq
+// строится по символам, а символ байта текста зависит от предыдущего байта.
+
+// ==============================================================================
+// | ApproxPattern(pattern, k, metric, mode).search(text, callback(end, dist)) |
+// | ApproxPattern(pattern, k, metric, mode).search(text, matches)             |
+// ==============================================================================
+
+enum class ApproxMetric { Hamming, Levenshtein };
+
+inline constexpr size_t APPROX_MAX_PATTERN = 64;
+
+[[nodiscard]] inline const char* ApproxMetricName(ApproxMetric metric) {
+    return metric == ApproxMetric::Hamming ? "Hamming" : "Levenshtein";
+}
+
+[[nodiscard]] inline ApproxMetric ParseApproxMetric(std::string_view name) {
+    if (name == "hamming") return ApproxMetric::Hamming;
+    if (name == "edit" || name == "levenshtein") return ApproxMetric::Levenshtein;
+    throw std::invalid_argument("Unknown approximate metric: " + std::string(name));
+}
+
+// ApproxMatch — одно вхождение: end — позиция сразу за его последним байтом,
+// distance — число замен (Hamming) или правок (Levenshtein).
+struct ApproxMatch {
+    size_t end;
+    uint32_t distance;
+};
+
+// Класс ApproxPattern — шаблон с допустимым расстоянием. После создания не
+// меняется, поиск не выделяет память, методы можно вызывать из нескольких потоков.
+class ApproxPattern {
+public:
+    // Шаблон — от 1 до APPROX_MAX_PATTERN байт, maxDistance меньше его длины (иначе
+    // вхождением было бы любое место текста).
+    ApproxPattern(std::string pattern, uint32_t maxDistance, ApproxMetric metric = ApproxMetric::Levenshtein,
+                  CaseMode mode = CaseMode::Sensitive)
+        : text(std::move(pattern)), k(maxDistance), metric_(metric), caseMode(mode) {
+        if (text.empty() || text.size() > APPROX_MAX_PATTERN) {
+            throw std::invalid_argument("ApproxPattern: pattern length must be 1.." +
+                                        std::to_string(APPROX_MAX_PATTERN));
+        }
+        if (k >= text.size()) {
+            throw std::invalid_argument("ApproxPattern: distance must be less than the pattern length");
+        }
+        high = uint64_t{1} << (text.size() - 1);
+
+        if (caseMode == CaseMode::Sensitive) {
+            eq.assign(256, 0);
+            for (size_t i = 0; i < text.size(); ++i) {
+                eq[static_cast<unsigned char>(text[i])] |= uint64_t{1} << i;
+            }
+        } else {
+            eq.assign(FOLD_SYMBOLS, 0);
+            const std::vector<uint16_t> symbols = CaseFoldString(text);
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                eq[symbols[i]] |= uint64_t{1} << i;
+            }
+        }
+    }
+
+    [[nodiscard]] const std::string& pattern() const { return text; }
+    [[nodiscard]] size_t size() const { return text.size(); }
+    [[nodiscard]] uint32_t maxDistance() const { return k; }
+    [[nodiscard]] ApproxMetric metric() const { return metric_; }
+    [[nodiscard]] CaseMode mode() const { return caseMode; }
+
+    // Передаёт каждое вхождение в callback(end, distance) по возрастанию end. Если
+    // callback возвращает bool, false останавливает поиск.
+    template <typename Callback>
+    void search(std::string_view haystack, Callback&& callback) const {
+        // Вхождение занимает не меньше m - k байт (m байт для Hamming): более короткие
+        // тексты — а это многие поля data.txt — отбрасываются без просмотра.
+        const size_t shortest = metric_ == ApproxMetric::Hamming ? text.size() : text.size() - k;
+        if (haystack.size() < shortest) {
+            return;
+        }
+        LAB_COUNT(BytesScanned, haystack.size());
+        const bool fold = caseMode == CaseMode::Insensitive;
+        if (metric_ == ApproxMetric::Hamming) {
+            fold ? scanBitap<true>(haystack, callback) : scanBitap<false>(haystack, callback);
+        } else {
+            fold ? scanMyers<true>(haystack, callback) : scanMyers<false>(haystack, callback);
+        }
+    }
+
+    // Вхождения в matches (вектор очищается, буфер переиспользуется).
+    void search(std::string_view haystack, std::vector<ApproxMatch>& matches) const {
+        matches.clear();
+        search(haystack, [&matches](size_t end, uint32_t distance) { matches.push_back(ApproxMatch{end, distance}); });
+    }
+
+    [[nodiscard]] size_t count(std::string_view haystack) const {
+        size_t n = 0;
+        search(haystack, [&n](size_t, uint32_t) { ++n; });
+        return n;
+    }
+
+private:
+    std::string text;
+    uint32_t k;
+    ApproxMetric metric_;
+    CaseMode caseMode;
+    // eq[c] — биты позиций шаблона, равных байту (символу свёртки) c.
+    std::vector<uint64_t> eq;
+    // Бит последнего байта шаблона.
+    uint64_t high = 0;
+
+    template <typename Callback>
+    static bool emit(Callback& callback, size_t end, uint32_t distance) {
+        LAB_COUNT(Matches, 1);
+        if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t, uint32_t>, bool>) {
+            return callback(end, distance);
+        } else {
+            callback(end, distance);
+            return true;
+        }
+    }
+
+    // Маска Eq для байта текста; row — строка свёртки предыдущего байта.
+    template <bool Fold>
+    uint64_t mask(unsigned char b, uint8_t& row) const {
+        if constexpr (Fold) {
+            const uint64_t m = eq[CaseFoldTable()[row * 256 + b]];
+            row = CaseFoldRow(b);
+            return m;
+        } else {
+            (void)row;
+            return eq[b];
+        }
+    }
+
+    // Для k = 1 и k = 2 (Fixed) слова состояния живут в регистрах, а цикл по ним
+    // развёрнут; для остальных k (Fixed = 0) число слов берётся из шаблона.
+    template <bool Fold, typename Callback>
+    void scanBitap(std::string_view haystack, Callback& callback) const {
+        switch (k) {
+            case 1:
+                scanBitapFixed<Fold, 1>(haystack, callback);
+                break;
+            case 2:
+                scanBitapFixed<Fold, 2>(haystack, callback);
+                break;
+            default:
+                scanBitapFixed<Fold, 0>(haystack, callback);
+                break;
+        }
+    }
+
+    template <bool Fold, uint32_t Fixed, typename Callback>
+    void scanBitapFixed(std::string_view haystack, Callback& callback) const {
+        const uint64_t last = high;
+        const uint32_t limit = Fixed != 0 ? Fixed : k;
+        std::array<uint64_t, Fixed != 0 ? Fixed + 1 : APPROX_MAX_PATTERN> state{};
+        uint8_t row = 0;
+        for (size_t pos = 0; pos < haystack.size(); ++pos) {
+            const uint64_t m = mask<Fold>(static_cast<unsigned char>(haystack[pos]), row);
+            // previous — слово j - 1 до обновления: замена в текущей позиции.
+            uint64_t previous = state[0];
+            state[0] = ((state[0] << 1) | 1) & m;
+            for (uint32_t j = 1; j <= limit; ++j) {
+                const uint64_t current = state[j];
+                state[j] = (((current << 1) | 1) & m) | (previous << 1) | 1;
+                previous = current;
+            }
+            // Слова вложены (S0 ⊆ S1 ⊆ ... ⊆ Sk): без бита в Sk вхождения нет.
+            if ((state[limit] & last) == 0) {
+                continue;
+            }
+            uint32_t distance = 0;
+            while ((state[distance] & last) == 0) {
+                ++distance;
+            }
+            if (!emit(callback, pos + 1, distance)) {
+                return;
+            }
+        }
+    }
+
+    template <bool Fold, typename Callback>
+    void scanMyers(std::string_view haystack, Callback& callback) const {
+        const uint64_t last = high;
+        const uint32_t limit = k;
+        uint64_t pv = ~uint64_t{0};
+        uint64_t mv = 0;
+        uint32_t score = static_cast<uint32_t>(text.size());
+        uint8_t row = 0;
+        for (size_t pos = 0; pos < haystack.size(); ++pos) {
+            const uint64_t m = mask<Fold>(static_cast<unsigned char>(haystack[pos]), row);
+            const uint64_t xv = m | mv;
+            const uint64_t xh = (((m & pv) + pv) ^ pv) | m;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            score += static_cast<uint32_t>((ph & last) != 0) - static_cast<uint32_t>((mh & last) != 0);
+            // Вхождение может начаться в любой позиции текста: верхняя строка таблицы
+            // нулевая, поэтому в младший бит после сдвига ничего не вносится.
+            ph <<= 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            if (score <= limit && !emit(callback, pos + 1, score)) {
+                return;
+            }
+        }
+    }
+};
+
+#endif // APPROX_HPP
@@ -0,0 +1,466 @@
+// ============================================================================
+// Данный заголовочный файл содержит пакетный режим: корпус загружается один раз,
+// а запросы (наборы шаблонов с движком и полем) читаются потоком и выполняются
+// по очереди с замером времени каждого.
+// ============================================================================
+
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "approx.hpp"
+#include "dynamic.hpp"
+#include "output.hpp"
+#include "parallel.hpp"
+#include "planner.hpp"
+#include "query.hpp"
+#include "records.hpp"
+#include "smallset.hpp"
+#include "suffix.hpp"
+
+// Формат потока запросов — одна команда в строке; пустые строки и строки,
+// начинающиеся с '#', пропускаются:
+//   kmp   [-i] [-f FIELD] PATTERN...  — позиции каждого шаблона (SinglePattern);
+//   all   [-i] [-f FIELD] PATTERN...  — поля, содержащие все шаблоны (PatternMatcher);
+//   query [-i] SPEC                   — строки, подходящие под запрос (FieldQuery),
+//                                       SPEC — весь остаток строки;
+//   approx [-i] [-f FIELD] [-d K] [-m METRIC] PATTERN...
+//                                     — приближённые вхождения (ApproxPattern): не больше
+//                                       K правок (-m edit, по умолчанию) или замен
+//                                       (-m hamming), K по умолчанию 1; в результатах
+//                                       конец вхождения (end) и расстояние (distance),
+//                                       см. MatchKind::Approximate в output.hpp;
+//   dict add PATTERN...               — добавить шаблоны в словарь пакета (LivePatternSet);
+//   dict remove PATTERN...            — удалить из словаря все копии шаблонов;
+//   dict find [-f FIELD]              — позиции всех шаблонов словаря; номер шаблона в
+//                                       результатах — его номер в словаре (по порядку
+//                                       добавления с 0).
+// -i — без учёта регистра, -f — номер поля (0, 1, 2) или '*' (все поля, по умолчанию).
+// Шаблон — слово без пробелов или строка в кавычках "..." (внутри \" и \\).
+// Пример:
+//   kmp 2720 628 4 Щ Я
+//   all -f 2 6 2 8 7
+//   approx -d 1 2720 628
+//   query 0:2720 AND NOT 2:{9}
+//   dict add 2720 628
+//   dict find -f 0
+//
+// Логика выполнения:
+// 1. Корпус разбирается в RecordStore один раз до первого запроса.
+// 2. Каждый запрос компилируется (планировщик, выбор движка, автомат запроса) и
+//    выполняется по корпусу параллельно (ParallelChunks), вывод собирается в
+//    OrderedBuffers и пишется в общий файл результатов под заголовком с номером
+//    и текстом запроса.
+//    Если передан суффиксный индекс корпуса (suffix.hpp), команды kmp без -i не
+//    просматривают корпус: вхождения каждого шаблона берутся из индекса и
+//    сортируются в тот же порядок, что даёт поиск по строкам.
+//    Словарь живёт весь пакет: dict add и dict remove меняют его без перестройки
+//    автомата (dynamic.hpp), а dict find ищет по снимку словаря, взятому в начале
+//    команды.
+// 3. Время запроса — от разбора команды до записи её результатов; оно пишется в
+//    подвал результатов и в журнал (log) вместе с числом совпадений. Ошибочный
+//    запрос попадает в журнал и не прерывает пакет.
+
+// ==================================================================
+// | ParseBatchCommand(line) -> BatchCommand                        |
+// | BatchRunner(words, threads, format[, index]).run(in, results, log) |
+// ==================================================================
+
+enum class BatchKind { Positions, ContainsAll, Expression, Approximate, DictAdd, DictRemove, DictFind };
+
+inline constexpr uint32_t ANY_BATCH_FIELD = UINT32_MAX;
+
+struct BatchCommand {
+    BatchKind kind = BatchKind::Positions;
+    CaseMode mode = CaseMode::Sensitive;
+    // Номер поля или ANY_BATCH_FIELD — все поля.
+    uint32_t field = ANY_BATCH_FIELD;
+    // Только для approx: допустимое расстояние и метрика.
+    uint32_t distance = 1;
+    ApproxMetric metric = ApproxMetric::Levenshtein;
+    std::vector<std::string> patterns;
+    std::string spec;
+};
+
+// Разбивает строку на слова и строки в кавычках.
+[[nodiscard]] inline std::vector<std::string> SplitBatchWords(std::string_view line) {
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        if (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r') {
+            ++pos;
+            continue;
+        }
+        std::string word;
+        if (line[pos] == '"') {
+            ++pos;
+            while (pos < line.size() && line[pos] != '"') {
+                if (line[pos] == '\\' && pos + 1 < line.size()) {
+                    ++pos;
+                }
+                word += line[pos++];
+            }
+            if (pos == line.size()) {
+                throw std::invalid_argument("Batch: unterminated string");
+            }
+            ++pos;
+        } else {
+            while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r') {
+                word += line[pos++];
+            }
+        }
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+[[nodiscard]] inline BatchCommand ParseBatchCommand(std::string_view line) {
+    BatchCommand command;
+    const size_t nameEnd = std::min(line.find_first_of(" \t"), line.size());
+    const std::string_view name = line.substr(0, nameEnd);
+    std::string_view rest = line.substr(nameEnd);
+
+    if (name == "kmp") {
+        command.kind = BatchKind::Positions;
+    } else if (name == "all") {
+        command.kind = BatchKind::ContainsAll;
+    } else if (name == "query") {
+        command.kind = BatchKind::Expression;
+    } else if (name == "approx") {
+        command.kind = BatchKind::Approximate;
+    } else if (name == "dict") {
+        rest = rest.substr(std::min(rest.find_first_not_of(" \t"), rest.size()));
+        const size_t actionEnd = std::min(rest.find_first_of(" \t"), rest.size());
+        const std::string_view action = rest.substr(0, actionEnd);
+        if (action == "add") {
+            command.kind = BatchKind::DictAdd;
+        } else if (action == "remove") {
+            command.kind = BatchKind::DictRemove;
+        } else if (action == "find") {
+            command.kind = BatchKind::DictFind;
+        } else {
+            throw std::invalid_argument("Batch: unknown dict command '" + std::string(action) + "'");
+        }
+        rest = rest.substr(actionEnd);
+    } else {
+        throw std::invalid_argument("Batch: unknown command '" + std::string(name) + "'");
+    }
+
+    if (command.kind == BatchKind::Expression) {
+        // Спецификация запроса разбирается FieldQuery; здесь снимается только -i.
+        rest = rest.substr(std::min(rest.find_first_not_of(" \t"), rest.size()));
+        if (rest.substr(0, 2) == "-i" && (rest.size() == 2 || rest[2] == ' ' || rest[2] == '\t')) {
+            command.mode = CaseMode::Insensitive;
+            rest = rest.substr(2);
+        }
+        command.spec = std::string(rest);
+        return command;
+    }
+
+    const std::vector<std::string> words = SplitBatchWords(rest);
+    size_t k = 0;
+    for (; k < words.size(); ++k) {
+        if (words[k] == "-i") {
+            command.mode = CaseMode::Insensitive;
+        } else if (words[k] == "-f" && k + 1 < words.size()) {
+            const std::string& field = words[++k];
+            if (field == "*") {
+                command.field = ANY_BATCH_FIELD;
+            } else if (field.size() == 1 && field[0] >= '0' && field[0] < '0' + static_cast<char>(RecordView::size())) {
+                command.field = static_cast<uint32_t>(field[0] - '0');
+            } else {
+                throw std::invalid_argument("Batch: invalid field '" + field + "'");
+            }
+        } else if (command.kind == BatchKind::Approximate && words[k] == "-d" && k + 1 < words.size()) {
+            const std::string& distance = words[++k];
+            if (distance.empty() || distance.size() > 2 ||
+                distance.find_first_not_of("0123456789") != std::string::npos) {
+                throw std::invalid_argument("Batch: invalid distance '" + distance + "'");
+            }
+            command.distance = static_cast<uint32_t>(std::stoul(distance));
+        } else if (command.kind == BatchKind::Approximate && words[k] == "-m" && k + 1 < words.size()) {
+            command.metric = ParseApproxMetric(words[++k]);
+        } else {
+            break;
+        }
+    }
+    command.patterns.assign(words.begin() + static_cast<std::ptrdiff_t>(k), words.end());
+    const bool dictionary =
+        command.kind == BatchKind::DictAdd || command.kind == BatchKind::DictRemove || command.kind == BatchKind::DictFind;
+    if (dictionary && command.mode == CaseMode::Insensitive) {
+        throw std::invalid_argument("Batch: dict commands are case-sensitive");
+    }
+    if (command.kind == BatchKind::DictFind) {
+        if (!command.patterns.empty()) {
+            throw std::invalid_argument("Batch: dict find takes no patterns");
+        }
+    } else if (command.patterns.empty()) {
+        throw std::invalid_argument("Batch: no patterns");
+    }
+    return command;
+}
+
+// Класс BatchRunner выполняет запросы по одному загруженному корпусу. Буферы
+// потоков переиспользуются между запросами.
+class BatchRunner {
+public:
+    // Размер куска строк для параллельного планировщика.
+    static constexpr size_t LINES_PER_CHUNK = 1024;
+
+    // index — суффиксный индекс того же корпуса или nullptr.
+    BatchRunner(const RecordStore& words, size_t threads, ResultFormat format, const SuffixIndex* index = nullptr)
+        : words(words), index(index), threads(threads), format(format),
+          fieldLength(words.bytes() / std::max<size_t>(words.size() * RecordView::size(), 1)),
+          positions(threads), states(threads), seen(threads), lines(threads), dictionaryMatches(threads) {}
+
+    struct Summary {
+        size_t queries = 0;
+        size_t failed = 0;
+        uint64_t matches = 0;
+        double totalMs = 0;
+        std::vector<double> latencies;
+    };
+
+    // Читает команды из in до конца потока; результаты пишет в results, строку
+    // журнала на каждый запрос — в log. Возвращает сводку по пакету.
+    Summary run(std::istream& in, ResultWriter& results, std::ostream& log) {
+        Summary summary;
+        std::string line;
+        while (std::getline(in, line)) {
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+            const size_t last = line.find_last_not_of(" \t\r");
+            const std::string_view text = std::string_view(line).substr(first, last + 1 - first);
+            const size_t number = ++summary.queries;
+
+            const auto start = std::chrono::steady_clock::now();
+            uint64_t found = 0;
+            try {
+                found = execute(number, text, results);
+            } catch (const std::exception& e) {
+                ++summary.failed;
+                log << "query " << number << ": error: " << e.what() << "\n";
+                continue;
+            }
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            summary.matches += found;
+            summary.totalMs += ms;
+            summary.latencies.push_back(ms);
+            log << "query " << number << ": " << found << " matches, " << ms << " ms\n";
+        }
+        return summary;
+    }
+
+private:
+    const RecordStore& words;
+    const SuffixIndex* index;
+    size_t threads;
+    ResultFormat format;
+    size_t fieldLength;
+    std::vector<std::vector<size_t>> positions;
+    std::vector<std::vector<uint8_t>> states;
+    std::vector<std::vector<uint64_t>> seen;
+    std::vector<std::string> lines;
+    // Словарь пакета и номера каждого текста шаблона в нём (для dict remove).
+    LivePatternSet dictionary;
+    std::unordered_map<std::string, std::vector<uint32_t>> dictionaryIds;
+    std::vector<std::vector<AcMatch>> dictionaryMatches;
+
+    // Выполняет одну команду и возвращает число записанных совпадений.
+    uint64_t execute(size_t number, std::string_view text, ResultWriter& results) {
+        const auto start = std::chrono::steady_clock::now();
+        const BatchCommand command = ParseBatchCommand(text);
+        OrderedBuffers out(threads);
+        std::vector<uint64_t> counts(threads, 0);
+
+        const size_t fieldBegin = command.field == ANY_BATCH_FIELD ? 0 : command.field;
+        const size_t fieldEnd = command.field == ANY_BATCH_FIELD ? RecordView::size() : command.field + 1;
+
+        if (command.kind == BatchKind::Positions && index != nullptr && command.mode == CaseMode::Sensitive) {
+            // Порядок как у поиска по строкам: запись, поле, шаблон, смещение.
+            struct Hit {
+                size_t record;
+                uint32_t group;
+                uint32_t pattern;
+                size_t offset;
+            };
+            // Вхождения каждого шаблона уже идут в порядке корпуса; устойчивая сортировка
+            // по записи и полю сохраняет внутри поля порядок шаблонов и смещений.
+            std::vector<Hit> hits;
+            for (size_t p = 0; p < command.patterns.size(); ++p) {
+                for (const SuffixHit& hit : index->locate(command.patterns[p])) {
+                    if (hit.group >= fieldBegin && hit.group < fieldEnd) {
+                        hits.push_back(Hit{hit.record, hit.group, static_cast<uint32_t>(p), hit.offset});
+                    }
+                }
+            }
+            if (command.patterns.size() > 1) {
+                std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+                    return std::tie(a.record, a.group) < std::tie(b.record, b.group);
+                });
+            }
+            std::string& buffer = out.begin(0, 0);
+            for (const Hit& hit : hits) {
+                AppendMatch(buffer, format, MatchRecord{hit.record + 1, hit.group, hit.offset, hit.pattern,
+                                                        words.field(hit.record, hit.group)});
+            }
+            out.end(0);
+            counts[0] = hits.size();
+        } else if (command.kind == BatchKind::Positions) {
+            std::vector<SinglePattern> compiled;
+            for (const auto& pattern : command.patterns) {
+                compiled.emplace_back(pattern, command.mode, fieldLength);
+            }
+            ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                           [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+                std::string& buffer = out.begin(worker, chunk);
+                for (size_t i = begin; i < end; ++i) {
+                    const RecordView v = words[i];
+                    for (size_t j = fieldBegin; j < fieldEnd; ++j) {
+                        for (size_t p = 0; p < compiled.size(); ++p) {
+                            compiled[p].search(v[j], positions[worker]);
+                            for (const size_t match : positions[worker]) {
+                                AppendMatch(buffer, format, MatchRecord{i + 1, static_cast<uint32_t>(j), match,
+                                                                        static_cast<uint32_t>(p), v[j]});
+                            }
+                            counts[worker] += positions[worker].size();
+                        }
+                    }
+                }
+                out.end(worker);
+            });
+        } else if (command.kind == BatchKind::Approximate) {
+            std::vector<ApproxPattern> compiled;
+            for (const auto& pattern : command.patterns) {
+                compiled.emplace_back(pattern, command.distance, command.metric, command.mode);
+            }
+            ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                           [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+                std::string& buffer = out.begin(worker, chunk);
+                for (size_t i = begin; i < end; ++i) {
+                    const RecordView v = words[i];
+                    for (size_t j = fieldBegin; j < fieldEnd; ++j) {
+                        for (size_t p = 0; p < compiled.size(); ++p) {
+                            compiled[p].search(v[j], [&](size_t matchEnd, uint32_t distance) {
+                                AppendMatch(buffer, format, MatchRecord{i + 1, static_cast<uint32_t>(j), matchEnd,
+                                                                        static_cast<uint32_t>(p), v[j], distance});
+                                ++counts[worker];
+                            });
+                        }
+                    }
+                }
+                out.end(worker);
+            });
+        } else if (command.kind == BatchKind::DictAdd) {
+            const std::vector<uint32_t> ids = dictionary.add(command.patterns);
+            for (size_t p = 0; p < ids.size(); ++p) {
+                dictionaryIds[command.patterns[p]].push_back(ids[p]);
+            }
+            counts[0] = ids.size();
+        } else if (command.kind == BatchKind::DictRemove) {
+            std::vector<uint32_t> ids;
+            for (const auto& pattern : command.patterns) {
+                const auto it = dictionaryIds.find(pattern);
+                if (it != dictionaryIds.end()) {
+                    ids.insert(ids.end(), it->second.begin(), it->second.end());
+                    dictionaryIds.erase(it);
+                }
+            }
+            counts[0] = dictionary.remove(ids);
+        } else if (command.kind == BatchKind::DictFind) {
+            // Снимок держится до конца команды: фоновое слияние словаря его не меняет.
+            const std::shared_ptr<const PatternSnapshot> snapshot = dictionary.snapshot();
+            ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                           [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+                std::string& buffer = out.begin(worker, chunk);
+                std::vector<AcMatch>& matches = dictionaryMatches[worker];
+                for (size_t i = begin; i < end; ++i) {
+                    const RecordView v = words[i];
+                    for (size_t j = fieldBegin; j < fieldEnd; ++j) {
+                        snapshot->search(v[j], matches);
+                        for (const AcMatch& match : matches) {
+                            AppendMatch(buffer, format,
+                                        MatchRecord{i + 1, static_cast<uint32_t>(j),
+                                                    match.end - snapshot->patternLength(match.pattern), match.pattern,
+                                                    v[j]});
+                        }
+                        counts[worker] += matches.size();
+                    }
+                }
+                out.end(worker);
+            });
+        } else if (command.kind == BatchKind::ContainsAll) {
+            const PatternMatcher matcher(command.patterns, command.mode);
+            ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                           [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+                std::string& buffer = out.begin(worker, chunk);
+                for (size_t i = begin; i < end; ++i) {
+                    const RecordView v = words[i];
+                    for (size_t j = fieldBegin; j < fieldEnd; ++j) {
+                        if (matcher.containsAll(v[j], seen[worker])) {
+                            AppendMatch(buffer, format,
+                                        MatchRecord{i + 1, static_cast<uint32_t>(j), 0, ALL_PATTERNS, v[j]});
+                            ++counts[worker];
+                        }
+                    }
+                }
+                out.end(worker);
+            });
+        } else {
+            const FieldQuery query(command.spec, command.mode);
+            ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                           [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+                std::string& buffer = out.begin(worker, chunk);
+                for (size_t i = begin; i < end; ++i) {
+                    const RecordView v = words[i];
+                    if (query.matches(v, states[worker])) {
+                        std::string& line = lines[worker];
+                        line.assign(v[0]).append(" ").append(v[1]).append(" ").append(v[2]);
+                        AppendMatch(buffer, format, MatchRecord{i + 1, 0, 0, QUERY_MATCH, line});
+                        ++counts[worker];
+                    }
+                }
+                out.end(worker);
+            });
+        }
+
+        AppendHeader(results.buffer(), format, "Query " + std::to_string(number) + ": " + std::string(text),
+                     command.kind == BatchKind::Approximate ? MatchKind::Approximate : MatchKind::Exact);
+        out.forEachInOrder([&](std::string_view bytes) { results.write(bytes); });
+        AppendFooter(results.buffer(), format,
+                     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        // Результаты каждого запроса сразу уходят в файл: их можно читать, не дожидаясь
+        // конца пакета.
+        results.flush();
+
+        uint64_t total = 0;
+        for (const uint64_t c : counts) {
+            total += c;
+        }
+        return total;
+    }
+};
+
+// Перцентиль q (0..1) задержек пакета; 0 для пустого пакета.
+[[nodiscard]] inline double BatchPercentile(std::vector<double> latencies, double q) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    const size_t k = std::min(latencies.size() - 1, static_cast<size_t>(q * static_cast<double>(latencies.size())));
+    std::nth_element(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(k), latencies.end());
+    return latencies[k];
+}
+
+#endif // BATCH_HPP
@@ -0,0 +1,91 @@
+// ============================================================================
+// Данный заголовочный файл содержит таблицы свёртки регистра для поиска без
+// учёта регистра: ASCII и двухбайтовая кириллица UTF-8 (Щ/щ, Я/я, Ё/ё, ...).
+// ============================================================================
+
+#ifndef CASEFOLD_HPP
+#define CASEFOLD_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Логика свёртки:
+// Каждый байт текста заменяется символом свёрнутого алфавита, причём символ зависит
+// только от самого байта и от предыдущего байта. Позиции байт и символов совпадают
+// один к одному, поэтому KMP и Ахо–Корасик работают как обычно, а смещения совпадений
+// остаются байтовыми.
+//
+// 1. ASCII: 'A'..'Z' -> 'a'..'z'.
+// 2. Ведущие байты кириллицы 0xD0 и 0xD1 сворачиваются в один символ 0xD0.
+// 3. Байт продолжения после 0xD0/0xD1 кодирует символ целиком: пара (0xD0, c)
+//    даёт символ c, пара (0xD1, c) — 0x100 + (c - 0x80). Прописные буквы сначала
+//    переводятся в строчные: А–П (D0 90–9F) -> а–п (D0 B0–BF), Р–Я (D0 A0–AF) ->
+//    р–я (D1 80–8F), Ѐ–Џ и Ё (D0 80–8F) -> ѐ–џ и ё (D1 90–9F).
+// 4. Остальные байты не меняются.
+//
+// "Предыдущий байт" задаётся строкой таблицы (row): 0 — прочие, 1 — 0xD0, 2 — 0xD1.
+// Автомат хранит строку вместе с состоянием, а таблица CaseFoldTable() отображает
+// (row, byte) в символ за одно чтение.
+
+enum class CaseMode { Sensitive, Insensitive };
+
+// Размер свёрнутого алфавита: 256 байт + 64 символа для пар (0xD1, c).
+inline constexpr size_t FOLD_SYMBOLS = 256 + 64;
+inline constexpr size_t FOLD_ROWS = 3;
+
+[[nodiscard]] inline uint8_t CaseFoldRow(unsigned char byte) {
+    return byte == 0xD0 ? 1 : (byte == 0xD1 ? 2 : 0);
+}
+
+[[nodiscard]] inline uint16_t CaseFoldSymbolSlow(uint8_t row, unsigned char b) {
+    if (b >= 'A' && b <= 'Z') {
+        return static_cast<uint16_t>(b - 'A' + 'a');
+    }
+    if (b == 0xD1) {
+        return 0xD0;
+    }
+    const bool continuation = (b & 0xC0) == 0x80;
+    if (!continuation || row == 0) {
+        return b;
+    }
+    if (row == 1) {
+        if (b >= 0x90 && b <= 0x9F) return static_cast<uint16_t>(b + 0x20);               // А–П -> а–п
+        if (b >= 0xA0 && b <= 0xAF) return static_cast<uint16_t>(0x100 + (b - 0x20 - 0x80)); // Р–Я -> р–я
+        if (b >= 0x80 && b <= 0x8F) return static_cast<uint16_t>(0x100 + (b + 0x10 - 0x80)); // Ѐ–Џ -> ѐ–џ
+        return b;
+    }
+    return static_cast<uint16_t>(0x100 + (b - 0x80));
+}
+
+// Таблица FOLD_ROWS x 256: символ для каждой пары (row, byte).
+[[nodiscard]] inline const std::array<uint16_t, FOLD_ROWS * 256>& CaseFoldTable() {
+    static const auto table = [] {
+        std::array<uint16_t, FOLD_ROWS * 256> t{};
+        for (uint8_t row = 0; row < FOLD_ROWS; ++row) {
+            for (size_t b = 0; b < 256; ++b) {
+                t[row * 256 + b] = CaseFoldSymbolSlow(row, static_cast<unsigned char>(b));
+            }
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Свёртка строки шаблона в последовательность символов. Первый байт шаблона
+// сворачивается так, будто перед ним стоит байт из строки 0.
+[[nodiscard]] inline std::vector<uint16_t> CaseFoldString(std::string_view s) {
+    const auto& table = CaseFoldTable();
+    std::vector<uint16_t> symbols;
+    symbols.reserve(s.size());
+    uint8_t row = 0;
+    for (const char c : s) {
+        const auto b = static_cast<unsigned char>(c);
+        symbols.push_back(table[row * 256 + b]);
+        row = CaseFoldRow(b);
+    }
+    return symbols;
+}
+
+#endif // CASEFOLD_HPP
@@ -0,0 +1,421 @@
+// ============================================================================
+// Данный заголовочный файл содержит изменяемый набор шаблонов Ахо–Корасик:
+// шаблоны добавляются и удаляются без перестройки всего автомата, а поиск в
+// других потоках продолжается по согласованному снимку набора.
+// ============================================================================
+
+#ifndef DYNAMIC_HPP
+#define DYNAMIC_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ac.hpp"
+
+// Устройство набора (журнал небольших автоматов, как в LSM-деревьях):
+// 1. Набор — последовательность сегментов. Сегмент — неизменяемый AhoCorasick над
+//    частью шаблонов и постоянные номера этих шаблонов (по возрастанию). Номер
+//    выдаётся при добавлении и не переиспользуется.
+// 2. add строит сегмент только из новых шаблонов — время зависит от размера
+//    обновления, а не словаря, — и дописывает его в конец набора.
+// 3. remove автоматы не трогает: у сегмента есть маска удалённых шаблонов
+//    (копируется при записи), и поиск пропускает их вхождения.
+// 4. Фоновый поток сливает все сегменты в один автомат без удалённых шаблонов и
+//    подменяет им слитые сегменты. Сегменты, добавленные во время слияния, остаются
+//    в конце и сливаются следующим проходом, а удаления, сделанные во время
+//    слияния, переносятся в маску нового сегмента.
+//
+// Публикация (в стиле RCU):
+// Состояние набора — неизменяемый снимок PatternSnapshot за std::shared_ptr.
+// Читатель берёт текущий снимок одной атомарной загрузкой (std::atomic_load) и ищет
+// по нему сколько угодно долго; писатель собирает новый снимок из сегментов старого
+// и публикует его атомарной записью. Старый снимок, а с ним и сегменты, которые
+// больше нигде не нужны, освобождается, когда его отпустит последний читатель.
+// Писатели (add, remove и публикация слияния) упорядочены мьютексом; читатели его
+// не берут, а долгое построение слитого автомата идёт вне мьютекса.
+//
+// Поиск по снимку проходит текст один раз на сегмент. После слияния сегмент один, и
+// поиск стоит столько же, сколько поиск по автомату, построенному заново.
+
+// =====================================================================
+// | LivePatternSet(patterns, mode).add(patterns) -> ids / remove(ids) |
+// | LivePatternSet(...).snapshot()->search(text, callback(end, id))  |
+// =====================================================================
+
+class LivePatternSet;
+
+// Класс PatternSnapshot — неизменяемое состояние набора на момент публикации.
+// Методы можно вызывать из нескольких потоков одновременно.
+class PatternSnapshot {
+public:
+    [[nodiscard]] size_t size() const { return live; }
+    [[nodiscard]] size_t segmentCount() const { return parts.size(); }
+    [[nodiscard]] uint64_t version() const { return version_; }
+    [[nodiscard]] CaseMode mode() const { return caseMode; }
+
+    [[nodiscard]] bool contains(uint32_t id) const {
+        size_t part = 0;
+        size_t local = 0;
+        return locate(id, part, local) && !isRemoved(parts[part], local);
+    }
+
+    // Текст и длина шаблона id; исключение, если такого шаблона в снимке нет.
+    [[nodiscard]] const std::string& pattern(uint32_t id) const {
+        size_t part = 0;
+        size_t local = 0;
+        if (!locate(id, part, local) || isRemoved(parts[part], local)) {
+            throw std::out_of_range("PatternSnapshot: no pattern " + std::to_string(id));
+        }
+        return parts[part].segment->patterns[local];
+    }
+
+    [[nodiscard]] size_t patternLength(uint32_t id) const { return pattern(id).size(); }
+
+    // Передаёт каждое вхождение живого шаблона в callback(end, id). Сегменты
+    // просматриваются по очереди, поэтому end возрастает только внутри сегмента.
+    // Если callback возвращает bool, false прекращает поиск; тогда возвращает false.
+    template <typename Callback>
+    bool search(std::string_view text, Callback&& callback) const {
+        for (const Part& part : parts) {
+            const Segment& segment = *part.segment;
+            bool completed = true;
+            if (part.removedCount != 0) {
+                const uint8_t* removed = part.removed->data();
+                completed = segment.automaton.search(text, [&](size_t end, uint32_t local) {
+                    return removed[local] != 0 || emit(callback, end, segment.ids[local]);
+                });
+            } else if (segment.contiguous) {
+                // Номера подряд: номер шаблона вычисляется без обращения к памяти.
+                const uint32_t first = segment.ids.front();
+                completed = segment.automaton.search(
+                    text, [&](size_t end, uint32_t local) { return emit(callback, end, first + local); });
+            } else {
+                completed = segment.automaton.search(
+                    text, [&](size_t end, uint32_t local) { return emit(callback, end, segment.ids[local]); });
+            }
+            if (!completed) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Вхождения в out по возрастанию end, при равных end — по номеру шаблона
+    // (вектор очищается, буфер переиспользуется).
+    void search(std::string_view text, std::vector<AcMatch>& out) const {
+        out.clear();
+        search(text, [&out](size_t end, uint32_t id) { out.push_back(AcMatch{end, id}); });
+        // Один сегмент уже отдаёт вхождения по end; равные end (вложенные шаблоны)
+        // встречаются редко, поэтому полная сортировка нужна обычно только для
+        // нескольких сегментов.
+        const auto before = [](const AcMatch& a, const AcMatch& b) {
+            return a.end != b.end ? a.end < b.end : a.pattern < b.pattern;
+        };
+        if (!std::is_sorted(out.begin(), out.end(), before)) {
+            std::sort(out.begin(), out.end(), before);
+        }
+    }
+
+    [[nodiscard]] size_t count(std::string_view text) const {
+        size_t n = 0;
+        search(text, [&n](size_t, uint32_t) { ++n; });
+        return n;
+    }
+
+private:
+    friend class LivePatternSet;
+
+    struct Segment {
+        Segment(std::vector<std::string> texts, std::vector<uint32_t> numbers, CaseMode mode, size_t memoryBudget)
+            : automaton(texts, mode, memoryBudget), patterns(std::move(texts)), ids(std::move(numbers)),
+              contiguous(ids.back() - ids.front() + 1 == ids.size()) {}
+
+        AhoCorasick automaton;
+        std::vector<std::string> patterns;
+        std::vector<uint32_t> ids;
+        // ids — first, first + 1, ... (сегмент одного add или слияние без удалений).
+        bool contiguous;
+    };
+
+    // Сегмент и его маска удалённых шаблонов (nullptr, пока удалений не было).
+    struct Part {
+        std::shared_ptr<const Segment> segment;
+        std::shared_ptr<const std::vector<uint8_t>> removed;
+        size_t removedCount = 0;
+    };
+
+    std::vector<Part> parts;
+    size_t live = 0;
+    uint64_t version_ = 0;
+    CaseMode caseMode = CaseMode::Sensitive;
+
+    template <typename Callback>
+    static bool emit(Callback& callback, size_t end, uint32_t id) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t, uint32_t>, bool>) {
+            return callback(end, id);
+        } else {
+            callback(end, id);
+            return true;
+        }
+    }
+
+    [[nodiscard]] static bool isRemoved(const Part& part, size_t local) {
+        return part.removedCount != 0 && (*part.removed)[local] != 0;
+    }
+
+    // Номера растут от сегмента к сегменту и внутри сегмента, поэтому сегмент
+    // находится по последнему номеру, а шаблон в нём — двоичным поиском.
+    [[nodiscard]] bool locate(uint32_t id, size_t& part, size_t& local) const {
+        const auto it = std::lower_bound(parts.begin(), parts.end(), id,
+                                         [](const Part& p, uint32_t value) { return p.segment->ids.back() < value; });
+        if (it == parts.end()) {
+            return false;
+        }
+        const std::vector<uint32_t>& ids = it->segment->ids;
+        const auto found = std::lower_bound(ids.begin(), ids.end(), id);
+        if (found == ids.end() || *found != id) {
+            return false;
+        }
+        part = static_cast<size_t>(it - parts.begin());
+        local = static_cast<size_t>(found - ids.begin());
+        return true;
+    }
+};
+
+// Класс LivePatternSet — изменяемый набор шаблонов. add, remove и snapshot можно
+// вызывать из любых потоков; поиск идёт по снимку, полученному из snapshot().
+class LivePatternSet {
+public:
+    explicit LivePatternSet(CaseMode mode = CaseMode::Sensitive, size_t memoryBudget = AC_DEFAULT_MEMORY_BUDGET)
+        : LivePatternSet({}, mode, memoryBudget) {}
+
+    // Начальные шаблоны получают номера 0, 1, ... в порядке перечисления.
+    explicit LivePatternSet(const std::vector<std::string>& patterns, CaseMode mode = CaseMode::Sensitive,
+                            size_t memoryBudget = AC_DEFAULT_MEMORY_BUDGET)
+        : caseMode(mode), budget(memoryBudget) {
+        auto initial = std::make_shared<PatternSnapshot>();
+        initial->caseMode = mode;
+        current = std::move(initial);
+        add(patterns);
+        merger = std::thread([this] { mergeLoop(); });
+    }
+
+    LivePatternSet(const LivePatternSet&) = delete;
+    LivePatternSet& operator=(const LivePatternSet&) = delete;
+
+    ~LivePatternSet() {
+        {
+            const std::lock_guard<std::mutex> lock(mergeMutex);
+            stopping = true;
+        }
+        mergeWake.notify_all();
+        merger.join();
+    }
+
+    [[nodiscard]] CaseMode mode() const { return caseMode; }
+
+    // Текущий снимок; остаётся целым, пока его держит вызывающий, что бы ни
+    // происходило с набором.
+    [[nodiscard]] std::shared_ptr<const PatternSnapshot> snapshot() const { return std::atomic_load(&current); }
+
+    // Добавляет шаблоны одним снимком и возвращает их номера. Пустые шаблоны не принимаются.
+    std::vector<uint32_t> add(const std::vector<std::string>& patterns) {
+        for (const auto& p : patterns) {
+            if (p.empty()) {
+                throw std::invalid_argument("LivePatternSet: empty pattern");
+            }
+        }
+        if (patterns.empty()) {
+            return {};
+        }
+
+        const std::lock_guard<std::mutex> lock(writeMutex);
+        std::vector<uint32_t> ids(patterns.size());
+        for (uint32_t& id : ids) {
+            id = nextId++;
+        }
+        PatternSnapshot::Part part;
+        part.segment = std::make_shared<const PatternSnapshot::Segment>(patterns, ids, caseMode, budget);
+
+        auto next = copyCurrent();
+        next->parts.push_back(std::move(part));
+        next->live += patterns.size();
+        publish(std::move(next));
+        return ids;
+    }
+
+    uint32_t add(std::string pattern) { return add(std::vector<std::string>{std::move(pattern)}).front(); }
+
+    // Удаляет шаблоны одним снимком; неизвестные и уже удалённые номера пропускаются.
+    // Возвращает число удалённых шаблонов.
+    size_t remove(const std::vector<uint32_t>& ids) {
+        const std::lock_guard<std::mutex> lock(writeMutex);
+        auto next = copyCurrent();
+        // Маска каждого сегмента копируется не больше одного раза за вызов.
+        std::vector<std::shared_ptr<std::vector<uint8_t>>> masks(next->parts.size());
+        size_t removed = 0;
+        for (const uint32_t id : ids) {
+            size_t part = 0;
+            size_t local = 0;
+            if (!next->locate(id, part, local) || PatternSnapshot::isRemoved(next->parts[part], local)) {
+                continue;
+            }
+            PatternSnapshot::Part& target = next->parts[part];
+            if (!masks[part]) {
+                masks[part] = target.removed ? std::make_shared<std::vector<uint8_t>>(*target.removed)
+                                             : std::make_shared<std::vector<uint8_t>>(target.segment->ids.size(), 0);
+                target.removed = masks[part];
+            }
+            (*masks[part])[local] = 1;
+            ++target.removedCount;
+            ++removed;
+        }
+        if (removed != 0) {
+            next->live -= removed;
+            publish(std::move(next));
+        }
+        return removed;
+    }
+
+    bool remove(uint32_t id) { return remove(std::vector<uint32_t>{id}) != 0; }
+
+    // Ждёт, пока фоновое слияние не догонит все опубликованные изменения.
+    void waitForMerge() {
+        std::unique_lock<std::mutex> lock(mergeMutex);
+        mergeIdle.wait(lock, [this] { return !mergePending && !merging; });
+    }
+
+private:
+    CaseMode caseMode;
+    size_t budget;
+    // Текущий снимок: читается std::atomic_load, заменяется std::atomic_store под writeMutex.
+    std::shared_ptr<const PatternSnapshot> current;
+    std::mutex writeMutex;
+    uint32_t nextId = 0;
+
+    std::mutex mergeMutex;
+    std::condition_variable mergeWake;
+    std::condition_variable mergeIdle;
+    bool mergePending = false;
+    bool merging = false;
+    bool stopping = false;
+    std::thread merger;
+
+    [[nodiscard]] std::shared_ptr<PatternSnapshot> copyCurrent() const {
+        auto next = std::make_shared<PatternSnapshot>(*current);
+        ++next->version_;
+        return next;
+    }
+
+    // Вызывается под writeMutex.
+    void publish(std::shared_ptr<const PatternSnapshot> next) {
+        std::atomic_store(&current, std::move(next));
+        {
+            const std::lock_guard<std::mutex> lock(mergeMutex);
+            mergePending = true;
+        }
+        mergeWake.notify_one();
+    }
+
+    void mergeLoop() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mergeMutex);
+                mergeWake.wait(lock, [this] { return stopping || mergePending; });
+                if (stopping) {
+                    return;
+                }
+                mergePending = false;
+                merging = true;
+            }
+            // Если слияние не удалось (например, не хватило памяти), набор остаётся
+            // из нескольких сегментов: поиск по нему корректен, только медленнее.
+            try {
+                mergeOnce();
+            } catch (...) {
+            }
+            {
+                const std::lock_guard<std::mutex> lock(mergeMutex);
+                merging = false;
+            }
+            mergeIdle.notify_all();
+        }
+    }
+
+    // Сливает все сегменты снимка в один без удалённых шаблонов.
+    void mergeOnce() {
+        const std::shared_ptr<const PatternSnapshot> base = snapshot();
+        const size_t merged = base->parts.size();
+        if (merged == 0 || (merged == 1 && base->parts[0].removedCount == 0)) {
+            return;
+        }
+
+        std::vector<std::string> patterns;
+        std::vector<uint32_t> ids;
+        patterns.reserve(base->live);
+        ids.reserve(base->live);
+        for (const PatternSnapshot::Part& part : base->parts) {
+            for (size_t k = 0; k < part.segment->ids.size(); ++k) {
+                if (!PatternSnapshot::isRemoved(part, k)) {
+                    patterns.push_back(part.segment->patterns[k]);
+                    ids.push_back(part.segment->ids[k]);
+                }
+            }
+        }
+        PatternSnapshot::Part result;
+        if (!ids.empty()) {
+            result.segment = std::make_shared<const PatternSnapshot::Segment>(std::move(patterns), std::move(ids),
+                                                                              caseMode, budget);
+        }
+
+        const std::lock_guard<std::mutex> lock(writeMutex);
+        // Писатели только дописывают сегменты и меняют маски, поэтому первые merged
+        // сегментов текущего снимка — те же, что слиты. Удаления, сделанные за время
+        // слияния, переносятся в маску нового сегмента.
+        auto next = copyCurrent();
+        if (result.segment) {
+            std::shared_ptr<std::vector<uint8_t>> mask;
+            size_t k = 0;
+            for (size_t i = 0; i < merged; ++i) {
+                const PatternSnapshot::Part& was = base->parts[i];
+                const PatternSnapshot::Part& now = next->parts[i];
+                for (size_t j = 0; j < was.segment->ids.size(); ++j) {
+                    if (PatternSnapshot::isRemoved(was, j)) {
+                        continue;
+                    }
+                    if (PatternSnapshot::isRemoved(now, j)) {
+                        if (!mask) {
+                            mask = std::make_shared<std::vector<uint8_t>>(result.segment->ids.size(), 0);
+                        }
+                        (*mask)[k] = 1;
+                        ++result.removedCount;
+                    }
+                    ++k;
+                }
+            }
+            result.removed = std::move(mask);
+        }
+        std::vector<PatternSnapshot::Part> parts;
+        parts.reserve(next->parts.size() - merged + 1);
+        if (result.segment) {
+            parts.push_back(std::move(result));
+        }
+        parts.insert(parts.end(), next->parts.begin() + static_cast<std::ptrdiff_t>(merged), next->parts.end());
+        next->parts = std::move(parts);
+        // Слияние меняет только представление: live и содержимое снимка те же, поэтому
+        // повторное слияние не заказывается (новые изменения закажут его сами).
+        std::atomic_store(&current, std::shared_ptr<const PatternSnapshot>(std::move(next)));
+    }
+};
+
+#endif // DYNAMIC_HPP
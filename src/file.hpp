@@ -18,6 +18,23 @@
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <string_view>
+#include <array>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LAB_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define LAB_HAVE_MMAP 0
+#endif
 
 // =====================================
 //            Работа с файлом
@@ -237,4 +254,344 @@
     return result;
 }
 
+// =====================================
+//     Отображение файла в память
+// =====================================
+//
+// Функции *Mapped не копируют содержимое файла: файл отображается в память
+// через mmap, а строки, слова и группы возвращаются как string_view, указывающие
+// прямо в отображение. Время жизни отображения привязано к возвращаемому объекту,
+// поэтому views действительны, пока жив этот объект (в том числе после перемещения).
+// На системах без mmap файл читается целиком в один буфер.
+// -------------------------------------------------------------------------------
+// | MappedFile | FileToLinesMapped | FileToWordsMapped | LinesWithWordsMapped |
+// -------------------------------------------------------------------------------
+
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& filename) {
+#if LAB_HAVE_MMAP
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat file: " + filename);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to map file: " + filename);
+            }
+            ::madvise(addr, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(addr);
+        }
+        ::close(fd);
+#else
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+        size_ = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+        buffer_ = std::make_unique<char[]>(size_ + 1);
+        if (!file.read(buffer_.get(), static_cast<std::streamsize>(size_))) {
+            throw std::runtime_error("Failed to read entire file: " + filename);
+        }
+        data_ = buffer_.get();
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            MappedFile tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+#if LAB_HAVE_MMAP
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    [[nodiscard]] std::string_view view() const { return {data_, size_}; }
+    [[nodiscard]] size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if !LAB_HAVE_MMAP
+    std::unique_ptr<char[]> buffer_;
+#endif
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#if !LAB_HAVE_MMAP
+        std::swap(buffer_, other.buffer_);
+#endif
+    }
+};
+
+// GroupWords — первые семь слов строки: больше SplitByGroups не использует.
+using GroupWords = std::array<std::string_view, 7>;
+
+// MappedTokens — отображённый файл и views на его строки или слова.
+struct MappedTokens {
+    MappedFile file;
+    std::vector<std::string_view> tokens;
+};
+
+// MappedRecords — отображённый файл и три группы каждой строки (как в SplitByGroups).
+// Если между словами группы стоит ровно один пробел, группа — это просто кусок файла.
+// Иначе (табуляция, несколько пробелов) склеенная через пробел копия хранится в normalized.
+struct MappedRecords {
+    MappedFile file;
+    std::deque<std::string> normalized;
+    std::vector<std::array<std::string_view, 3>> records;
+};
+
+[[maybe_unused]] inline std::vector<std::string_view> SplitLinesView(std::string_view view) {
+    std::vector<std::string_view> lines;
+    lines.reserve(view.size() / 30);
+
+    size_t start = 0, end = 0;
+    while (end < view.size()) {
+        while (end < view.size() && view[end] != '\n' && view[end] != '\r') {
+            ++end;
+        }
+        if (start < end) {
+            lines.push_back(view.substr(start, end - start));
+        }
+        while (end < view.size() && (view[end] == '\n' || view[end] == '\r')) {
+            ++end;
+        }
+        start = end;
+    }
+    return lines;
+}
+
+[[maybe_unused]] inline std::vector<std::string_view> SplitWordsView(std::string_view view) {
+    std::vector<std::string_view> words;
+    words.reserve(view.size() / 5);
+
+    auto isSeparator = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+
+    size_t start = 0, end = 0;
+    while (end < view.size()) {
+        while (end < view.size() && isSeparator(view[end])) {
+            ++end;
+        }
+        start = end;
+        while (end < view.size() && !isSeparator(view[end])) {
+            ++end;
+        }
+        if (start < end) {
+            words.push_back(view.substr(start, end - start));
+        }
+    }
+    return words;
+}
+
+[[nodiscard]] inline MappedTokens FileToLinesMapped(const std::string& filename) {
+    MappedTokens result{MappedFile(filename), {}};
+    result.tokens = SplitLinesView(result.file.view());
+    return result;
+}
+
+[[nodiscard]] inline MappedTokens FileToWordsMapped(const std::string& filename) {
+    MappedTokens result{MappedFile(filename), {}};
+    result.tokens = SplitWordsView(result.file.view());
+    return result;
+}
+
+// Склеивает слова words[first .. last] через один пробел. Если в исходной строке они
+// уже разделены ровно одним пробелом, возвращает view на исходный кусок без копирования.
+inline std::string_view JoinGroupView(const GroupWords& words, size_t first, size_t last,
+                                      std::deque<std::string>& normalized) {
+    const char* begin = words[first].data();
+    const char* end = words[last].data() + words[last].size();
+
+    size_t joinedSize = last - first;
+    bool singleSpaces = true;
+    for (size_t k = first; k <= last; ++k) {
+        joinedSize += words[k].size();
+        if (k > first && words[k].data()[-1] != ' ') {
+            singleSpaces = false;
+        }
+    }
+    if (singleSpaces && static_cast<size_t>(end - begin) == joinedSize) {
+        return {begin, joinedSize};
+    }
+
+    std::string joined(words[first]);
+    for (size_t k = first + 1; k <= last; ++k) {
+        joined += ' ';
+        joined += words[k];
+    }
+    normalized.push_back(std::move(joined));
+    return normalized.back();
+}
+
+// ForEachGroupedLine повторяет разбор LinesWithWords: строки делятся по '\n', слова —
+// по пробельным символам, строки короче шести слов пропускаются с сообщением.
+// Для каждой подходящей строки вызывается fn(words, count), где words — первые
+// (не более семи) слов строки, а count — их число.
+template <typename Fn>
+void ForEachGroupedLine(std::string_view content, Fn&& fn) {
+    auto isSpace = [](char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    };
+
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t eol = content.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            eol = content.size();
+        }
+        const std::string_view line = content.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        // Нужны только первые семь слов, остальные SplitByGroups отбрасывает.
+        GroupWords words{};
+        size_t count = 0, i = 0;
+        while (i < line.size() && count < words.size()) {
+            while (i < line.size() && isSpace(line[i])) {
+                ++i;
+            }
+            const size_t start = i;
+            while (i < line.size() && !isSpace(line[i])) {
+                ++i;
+            }
+            if (start < i) {
+                words[count++] = line.substr(start, i - start);
+            }
+        }
+
+        if (count < 6) {
+            std::cerr << "Skipping line due to error: Invalid input format\n";
+            continue;
+        }
+
+        fn(words, count);
+    }
+}
+
+// Слова [first, last] строки, из которых состоит группа group (как в SplitByGroups).
+inline std::pair<size_t, size_t> GroupRange(size_t group, size_t count) {
+    switch (group) {
+        case 0: return {0, 1};
+        case 1: return {2, 4};
+        default: return {5, count > 6 ? 6 : 5};
+    }
+}
+
+[[nodiscard]] inline MappedRecords LinesWithWordsMapped(const std::string& filename) {
+    MappedRecords result{MappedFile(filename), {}, {}};
+    const std::string_view content = result.file.view();
+    result.records.reserve(content.size() / 40);
+
+    ForEachGroupedLine(content, [&](const GroupWords& words, size_t count) {
+        std::array<std::string_view, 3> record;
+        for (size_t g = 0; g < 3; ++g) {
+            const auto [first, last] = GroupRange(g, count);
+            record[g] = JoinGroupView(words, first, last, result.normalized);
+        }
+        result.records.push_back(record);
+    });
+
+    return result;
+}
+
+// =====================================
+//       Чтение файла по частям
+// =====================================
+//
+// ChunkReader читает файл последовательными частями фиксированного размера в один
+// переиспользуемый буфер, поэтому память не зависит от размера файла. Вместе с
+// KmpStream / AcStream это позволяет искать в файлах больше оперативной памяти:
+// ScanFileStream подаёт части файла потоковому сопоставителю.
+// ----------------------------------------------------------------
+// | ChunkReader(filename, chunkSize).next(chunk)                 |
+// | ForEachChunk(filename, chunkSize, fn)                        |
+// | ScanFileStream(filename, chunkSize, stream, callback)        |
+// ----------------------------------------------------------------
+
+class ChunkReader {
+public:
+    static constexpr size_t DEFAULT_CHUNK = 1 << 20;
+
+    explicit ChunkReader(const std::string& filename, size_t chunkSize = DEFAULT_CHUNK)
+        : file(filename, std::ios::binary), buffer(std::max<size_t>(chunkSize, 1)) {
+        if (!file) {
+            throw std::runtime_error("Failed to open file: " + filename);
+        }
+    }
+
+    // Читает следующую часть; view действителен до следующего вызова next.
+    // Возвращает false, когда файл закончился.
+    bool next(std::string_view& chunk) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const auto got = static_cast<size_t>(file.gcount());
+        if (got == 0) {
+            if (file.bad()) {
+                throw std::runtime_error("Error reading file");
+            }
+            return false;
+        }
+        chunk = std::string_view(buffer.data(), got);
+        return true;
+    }
+
+private:
+    std::ifstream file;
+    std::vector<char> buffer;
+};
+
+// Вызывает fn(chunk) для каждой части файла. Если fn возвращает bool,
+// значение false прекращает чтение.
+template <typename Fn>
+void ForEachChunk(const std::string& filename, size_t chunkSize, Fn&& fn) {
+    ChunkReader reader(filename, chunkSize);
+    std::string_view chunk;
+    while (reader.next(chunk)) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Fn&, std::string_view>, bool>) {
+            if (!fn(chunk)) {
+                return;
+            }
+        } else {
+            fn(chunk);
+        }
+    }
+}
+
+// ScanFileStream читает файл частями и подаёт их в stream.feed(chunk, callback) —
+// stream это KmpStream, AcStream или другой объект с тем же feed. Позиции в callback —
+// смещения от начала файла, вхождения на стыке частей не теряются. Возвращает false,
+// если callback остановил поиск.
+template <typename Stream, typename Callback>
+bool ScanFileStream(const std::string& filename, size_t chunkSize, Stream& stream, Callback&& callback) {
+    bool completed = true;
+    ForEachChunk(filename, chunkSize, [&](std::string_view chunk) {
+        completed = stream.feed(chunk, callback);
+        return completed;
+    });
+    return completed;
+}
+
 #endif // FILE_HPP
\ No newline at end of file
@@ -7,8 +7,17 @@
 #define KMP_HPP
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "simd.hpp"
+#include "casefold.hpp"
+#include "profile.hpp"
 
 // Логика алгоритма:
 // 1. Считаем префикс-функцию (pie - массив) для шаблона: для каждого символа записываем
@@ -23,6 +32,8 @@
 
 // ========================================================================
 // |      kmp_search(string text, string pattern, size_t match_count)     |
+// |      KmpPattern(string pattern).search(text, matches)                |
+// |      KmpStream(pattern).feed(chunk, callback)                        |
 // ========================================================================
 
 // lpfun long prefix function - это функция, которая для каждого символа в шаблоне 
@@ -97,4 +108,246 @@ inline size_t* kmp_search(const std::string& text, const std::string& pattern, s
     return matches;
 }
 
+// Класс KmpPattern вычисляет префикс-функцию шаблона один раз при создании.
+// Методы поиска не выделяют память: позиции пишутся в переиспользуемый вектор
+// вызывающего кода или передаются в callback. Объект после создания не меняется,
+// поэтому его можно использовать из нескольких потоков одновременно.
+//
+// С CaseMode::Insensitive префикс-функция строится по свёрнутым символам шаблона
+// (см. casefold.hpp), а байты текста сворачиваются той же таблицей на лету —
+// текст читается один раз и не копируется. Позиции остаются байтовыми.
+class KmpPattern {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit KmpPattern(std::string pattern, CaseMode mode = CaseMode::Sensitive)
+        : pattern_(std::move(pattern)), mode_(mode) {
+        if (mode_ == CaseMode::Insensitive) {
+            folded_ = CaseFoldString(pattern_);
+            pie_ = prefixFunction(folded_);
+        } else {
+            pie_ = prefixFunction(pattern_);
+        }
+    }
+
+    [[nodiscard]] const std::string& pattern() const { return pattern_; }
+    [[nodiscard]] size_t size() const { return pattern_.size(); }
+    [[nodiscard]] CaseMode mode() const { return mode_; }
+
+    // Один шаг автомата KMP: по числу совпавших символов matched_pos и очередному
+    // байту c возвращает новое число совпавших символов (size() — полное совпадение).
+    // row — вид предыдущего байта для свёртки регистра; шаг обновляет его.
+    [[nodiscard]] size_t advance(size_t matched_pos, uint8_t& row, char c) const {
+        if (mode_ == CaseMode::Insensitive) {
+            const auto b = static_cast<unsigned char>(c);
+            const uint16_t sym = CaseFoldTable()[row * 256 + b];
+            row = CaseFoldRow(b);
+            return step(folded_, matched_pos, sym);
+        }
+        return step(pattern_, matched_pos, c);
+    }
+
+    // Передаёт позицию начала каждого вхождения в callback(pos) по возрастанию.
+    // Если callback возвращает bool, значение false прекращает поиск.
+    // На длинных текстах позиции сначала отбираются SIMD-префильтром по первому и
+    // последнему байту шаблона (см. simd.hpp), а KMP продолжает с того места,
+    // где префильтр остановился.
+    template <typename Callback>
+    void search(std::string_view text, Callback&& callback) const {
+        const size_t size_ = pattern_.size();
+        if (size_ == 0 || text.size() < size_) {
+            return;
+        }
+        LAB_COUNT(BytesScanned, text.size());
+        if (mode_ == CaseMode::Insensitive) {
+            searchFolded(text, callback);
+            return;
+        }
+
+        size_t start = 0;
+        if (text.size() - size_ >= PREFILTER_MIN_TEXT) {
+            start = EdgeScan(text.data(), text.size(), size_, pattern_.front(), pattern_.back(),
+                             [&](size_t pos) {
+                if (size_ > 2 && std::memcmp(text.data() + pos + 1, pattern_.data() + 1, size_ - 2) != 0) {
+                    return true;
+                }
+                return emit(callback, pos);
+            });
+            if (start == SIMD_STOPPED) {
+                return;
+            }
+        }
+
+        size_t matched_pos = 0;
+        for (size_t cur = start; cur < text.size(); ++cur) {
+            while (matched_pos > 0 && pattern_[matched_pos] != text[cur]) {
+                matched_pos = pie_[matched_pos - 1];
+                LAB_COUNT(FailureSteps, 1);
+            }
+
+            if (pattern_[matched_pos] == text[cur]) {
+                ++matched_pos;
+            }
+
+            if (matched_pos == size_) {
+                if (!emit(callback, cur - size_ + 1)) {
+                    return;
+                }
+                matched_pos = pie_[matched_pos - 1];
+            }
+        }
+    }
+
+    // Записывает позиции всех вхождений в matches (старое содержимое удаляется).
+    void search(std::string_view text, std::vector<size_t>& matches) const {
+        matches.clear();
+        search(text, [&matches](size_t pos) { matches.push_back(pos); });
+    }
+
+    [[nodiscard]] size_t count(std::string_view text) const {
+        size_t result = 0;
+        search(text, [&result](size_t) { ++result; });
+        return result;
+    }
+
+    // Возвращает позицию первого вхождения или npos.
+    [[nodiscard]] size_t find_first(std::string_view text) const {
+        size_t result = npos;
+        search(text, [&result](size_t pos) {
+            result = pos;
+            return false;
+        });
+        return result;
+    }
+
+private:
+    // Более короткие тексты (типичные поля data.txt) префильтр только замедлит.
+    static constexpr size_t PREFILTER_MIN_TEXT = 32;
+
+    std::string pattern_;
+    CaseMode mode_ = CaseMode::Sensitive;
+    // folded_: свёрнутые символы шаблона (только для CaseMode::Insensitive).
+    std::vector<uint16_t> folded_;
+    std::vector<size_t> pie_;
+
+    template <typename Sequence>
+    static std::vector<size_t> prefixFunction(const Sequence& pattern) {
+        std::vector<size_t> pie(pattern.size());
+        size_t k = 0;
+        for (size_t i = 1; i < pattern.size(); ++i) {
+            while (k > 0 && pattern[k] != pattern[i]) {
+                k = pie[k - 1];
+            }
+            if (pattern[k] == pattern[i]) {
+                ++k;
+            }
+            pie[i] = k;
+        }
+        return pie;
+    }
+
+    template <typename Sequence, typename Symbol>
+    size_t step(const Sequence& pattern, size_t matched_pos, Symbol c) const {
+        if (matched_pos == pattern.size()) {
+            matched_pos = pie_[matched_pos - 1];
+        }
+        while (matched_pos > 0 && pattern[matched_pos] != c) {
+            matched_pos = pie_[matched_pos - 1];
+        }
+        if (pattern[matched_pos] == c) {
+            ++matched_pos;
+        }
+        return matched_pos;
+    }
+
+    template <typename Callback>
+    void searchFolded(std::string_view text, Callback& callback) const {
+        const auto& table = CaseFoldTable();
+        const size_t size_ = folded_.size();
+        size_t matched_pos = 0;
+        uint8_t row = 0;
+
+        for (size_t cur = 0; cur < text.size(); ++cur) {
+            const auto b = static_cast<unsigned char>(text[cur]);
+            const uint16_t sym = table[row * 256 + b];
+            row = CaseFoldRow(b);
+
+            while (matched_pos > 0 && folded_[matched_pos] != sym) {
+                matched_pos = pie_[matched_pos - 1];
+                LAB_COUNT(FailureSteps, 1);
+            }
+            if (folded_[matched_pos] == sym) {
+                ++matched_pos;
+            }
+            if (matched_pos == size_) {
+                if (!emit(callback, cur - size_ + 1)) {
+                    return;
+                }
+                matched_pos = pie_[matched_pos - 1];
+            }
+        }
+    }
+
+    template <typename Callback>
+    static bool emit(Callback& callback, size_t pos) {
+        LAB_COUNT(Matches, 1);
+        if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t>, bool>) {
+            return callback(pos);
+        } else {
+            callback(pos);
+            return true;
+        }
+    }
+};
+
+// Класс KmpStream — возобновляемый поиск шаблона в тексте, поступающем частями.
+// Состояние между частями — matched_pos (сколько символов шаблона уже совпало)
+// и число прочитанных байт, поэтому вхождения на стыке частей не теряются,
+// а callback получает глобальную позицию начала вхождения.
+class KmpStream {
+public:
+    explicit KmpStream(const KmpPattern& pattern) : pattern_(&pattern) {}
+
+    // Возвращает false, если callback остановил поиск.
+    template <typename Callback>
+    bool feed(std::string_view chunk, Callback&& callback) {
+        const size_t size_ = pattern_->size();
+        if (size_ == 0) {
+            offset_ += chunk.size();
+            return true;
+        }
+
+        for (size_t cur = 0; cur < chunk.size(); ++cur) {
+            matched_pos_ = pattern_->advance(matched_pos_, row_, chunk[cur]);
+            if (matched_pos_ == size_) {
+                const uint64_t start = offset_ + cur + 1 - size_;
+                if constexpr (std::is_same_v<std::invoke_result_t<Callback&, uint64_t>, bool>) {
+                    if (!callback(start)) {
+                        offset_ += cur + 1;
+                        return false;
+                    }
+                } else {
+                    callback(start);
+                }
+            }
+        }
+        offset_ += chunk.size();
+        return true;
+    }
+
+    void reset() {
+        matched_pos_ = 0;
+        row_ = 0;
+        offset_ = 0;
+    }
+
+    [[nodiscard]] uint64_t consumed() const { return offset_; }
+
+private:
+    const KmpPattern* pattern_;
+    size_t matched_pos_ = 0;
+    uint8_t row_ = 0;
+    uint64_t offset_ = 0;
+};
+
 #endif // KMP_HPP
\ No newline at end of file
@@ -1,77 +1,430 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <iomanip>
 #include <chrono>
+#include <fstream>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
 #include "ac.hpp"
+#include "acfile.hpp"
 #include "kmp.hpp"
+#include "planner.hpp"
 #include "file.hpp"
+#include "records.hpp"
+#include "parallel.hpp"
+#include "utf8.hpp"
+#include "output.hpp"
+#include "query.hpp"
+#include "smallset.hpp"
+#include "profile.hpp"
+#include "batch.hpp"
+#include "suffix.hpp"
+#include "suffixfile.hpp"
+#include "pipeline.hpp"
+
+#if LAB_PROFILE
+// В профилирующей сборке глобальный operator new считает выделения памяти (см. profile.hpp).
+LAB_DEFINE_COUNTING_NEW
+#endif
 
 const std::string KMP_RESULT_FILE = "../data/kmp_result.txt";
 const std::string AC_RESULT_FILE = "../data/ac_result.txt";
+const std::string QUERY_RESULT_FILE = "../data/query_result.txt";
+const std::string BATCH_RESULT_FILE = "../data/batch_result.txt";
+
+// Размер куска строк для параллельного планировщика.
+const size_t LINES_PER_CHUNK = 1024;
+
+// Параметры запуска:
+//   --threads N  число потоков (по умолчанию — все ядра);
+//   --utf8       позиции совпадений KMP в символах UTF-8, а не в байтах;
+//   --ignore-case  поиск без учёта регистра (ASCII и кириллица);
+//   --format F   формат результатов: table (по умолчанию), tsv, jsonl, binary;
+//   --save-automaton FILE  записать скомпилированный автомат Ахо–Корасик в файл;
+//   --load-automaton FILE  взять автомат из файла вместо построения (шаблоны и
+//                          режим регистра — те, с которыми он был сохранён);
+//   --ac-memory-budget BYTES  бюджет памяти автомата Ахо–Корасик (см. ac.hpp);
+//   --query SPEC  дополнительно отобрать строки по запросу (синтаксис — query.hpp),
+//                 например: --query '0:2720 AND 2:{6,2,8,7}';
+//   --data FILE   входной файл вместо ../data/data.txt;
+//   --batch FILE  пакетный режим (batch.hpp): корпус загружается один раз, команды
+//                 читаются из FILE ('-' — стандартный ввод), результаты всех команд
+//                 пишутся в ../data/batch_result.txt, время каждой — в stdout;
+//   --save-index FILE  построить суффиксный индекс корпуса (suffix.hpp) и записать в файл;
+//   --load-index FILE  взять индекс из файла (он должен быть построен по тому же файлу
+//                      данных); с индексом пакетный режим ищет позиции без просмотра корпуса;
+//   --phased      искать по корпусу, загруженному целиком, фаза за фазой (по умолчанию
+//                 файл проходит конвейер pipeline.hpp: чтение, разбор, поиск и запись
+//                 идут одновременно, оба движка — за один проход по каждому пакету);
+//   --profile FILE  записать при выходе отчёт JSON: время фаз и, в сборке с
+//                   -DLAB_PROFILE=1, счётчики горячего пути (см. profile.hpp).
+struct Options {
+    size_t threads = DefaultThreadCount();
+    bool utf8 = false;
+    CaseMode caseMode = CaseMode::Sensitive;
+    ResultFormat format = ResultFormat::Table;
+    std::string saveAutomaton;
+    std::string loadAutomaton;
+    size_t acMemoryBudget = AC_DEFAULT_MEMORY_BUDGET;
+    std::string query;
+    std::string profile;
+    std::string data = "../data/data.txt";
+    std::string batch;
+    std::string saveIndex;
+    std::string loadIndex;
+    bool phased = false;
+};
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int a = 1; a < argc; ++a) {
+        const std::string arg = argv[a];
+        if (arg == "--threads" && a + 1 < argc) {
+            options.threads = std::max<size_t>(std::stoul(argv[++a]), 1);
+        } else if (arg == "--utf8") {
+            options.utf8 = true;
+        } else if (arg == "--ignore-case") {
+            options.caseMode = CaseMode::Insensitive;
+        } else if (arg == "--format" && a + 1 < argc) {
+            options.format = ParseResultFormat(argv[++a]);
+        } else if (arg == "--save-automaton" && a + 1 < argc) {
+            options.saveAutomaton = argv[++a];
+        } else if (arg == "--load-automaton" && a + 1 < argc) {
+            options.loadAutomaton = argv[++a];
+        } else if (arg == "--ac-memory-budget" && a + 1 < argc) {
+            options.acMemoryBudget = std::stoull(argv[++a]);
+        } else if (arg == "--query" && a + 1 < argc) {
+            options.query = argv[++a];
+        } else if (arg == "--profile" && a + 1 < argc) {
+            options.profile = argv[++a];
+        } else if (arg == "--data" && a + 1 < argc) {
+            options.data = argv[++a];
+        } else if (arg == "--batch" && a + 1 < argc) {
+            options.batch = argv[++a];
+        } else if (arg == "--save-index" && a + 1 < argc) {
+            options.saveIndex = argv[++a];
+        } else if (arg == "--load-index" && a + 1 < argc) {
+            options.loadIndex = argv[++a];
+        } else if (arg == "--phased") {
+            options.phased = true;
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    return options;
+}
+
+// Шаблоны примера: KMP ищет каждый шаблон по отдельности, Ахо–Корасик — все сразу.
+const std::vector<std::string> KMP_PATTERNS = {"2720", "628", "4", "Щ", "Я"};
+const std::vector<std::string> AC_PATTERNS = {"6", "2", "8", "7"};
+
+// Буферы одного потока поиска, переиспользуемые между записями.
+struct SearchScratch {
+    std::vector<size_t> matches;
+    std::vector<uint8_t> states;
+    std::vector<uint64_t> seen;
+    std::string line;
+};
+
+// Совпадения шаблонов KMP в полях записи v (line — номер строки файла с единицы).
+void appendKmpMatches(std::string& out, const Options& options, const std::vector<SinglePattern>& patterns,
+                      size_t line, const RecordView& v, SearchScratch& scratch) {
+    for (size_t j = 0; j < 3; ++j) {
+        // Поле проверяется и индексируется один раз на все шаблоны, при первом совпадении.
+        Utf8Offsets offsets(v[j]);
+        bool utf8Checked = false;
+        bool utf8Valid = false;
+
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            patterns[p].search(v[j], scratch.matches);
+
+            if (options.utf8 && !scratch.matches.empty() && !utf8Checked) {
+                utf8Valid = ValidateUtf8(v[j]);
+                utf8Checked = true;
+            }
+            // Некорректный UTF-8 оставляем с байтовыми позициями.
+            if (utf8Valid) {
+                for (size_t& match : scratch.matches) {
+                    match = offsets.toCodepoint(match);
+                }
+            }
 
-void writeHeader(std::ofstream& out, const std::string& header) {
-    out << "===========================================\n";
-    out << header << "\n";
-    out << "-------------------------------------------\n";
-    out << std::left << std::setw(10) << "Line" 
-        << std::setw(40) << "Data" 
-        << std::setw(20) << "Match Index\n";
-    out << "-------------------------------------------\n";
+            for (size_t match : scratch.matches) {
+                AppendMatch(out, options.format,
+                            MatchRecord{line, static_cast<uint32_t>(j), match, static_cast<uint32_t>(p), v[j]});
+            }
+        }
+    }
 }
 
-void writeFooter(std::ofstream& out, double time_ms) {
-    out << "-------------------------------------------\n";
-    out << "Execution time: " << time_ms << " ms\n";
-    out << "===========================================\n\n";
+// Поля записи v, содержащие все шаблоны Ахо–Корасик.
+void appendAcMatches(std::string& out, const Options& options, const PatternMatcher& ac, size_t line,
+                     const RecordView& v, SearchScratch& scratch) {
+    for (size_t j = 0; j < 3; ++j) {
+        if (ac.containsAll(v[j], scratch.seen)) {
+            AppendMatch(out, options.format, MatchRecord{line, static_cast<uint32_t>(j), 0, ALL_PATTERNS, v[j]});
+        }
+    }
 }
 
-int main() {
-    std::string filename = "../data/data.txt";
+// Запись v целиком, если она подходит под запрос: все поля проверяются одним
+// автоматом за один проход.
+void appendQueryMatch(std::string& out, const Options& options, const FieldQuery& query, size_t line,
+                      const RecordView& v, SearchScratch& scratch) {
+    if (query.matches(v, scratch.states)) {
+        scratch.line.assign(v[0]).append(" ").append(v[1]).append(" ").append(v[2]);
+        AppendMatch(out, options.format, MatchRecord{line, 0, 0, QUERY_MATCH, scratch.line});
+    }
+}
 
-    // Открываем файлы для записи результатов
-    std::ofstream kmpFile(KMP_RESULT_FILE);
-    std::ofstream acFile(AC_RESULT_FILE);
+// Движок Ахо–Корасик выбирается по набору шаблонов (см. smallset.hpp), строится один
+// раз и используется всеми потоками только для чтения. Если автомат нужно загрузить
+// или сохранить, поиск идёт по самому автомату.
+PatternMatcher buildAcMatcher(const Options& options) {
+    if (options.loadAutomaton.empty() && options.saveAutomaton.empty()) {
+        return PatternMatcher(AC_PATTERNS, options.caseMode, options.acMemoryBudget);
+    }
+    AhoCorasick automaton = options.loadAutomaton.empty()
+                                ? AhoCorasick(AC_PATTERNS, options.caseMode, options.acMemoryBudget)
+                                : LoadAutomaton(options.loadAutomaton);
+    if (!options.saveAutomaton.empty()) {
+        SaveAutomaton(automaton, options.saveAutomaton);
+    }
+    return PatternMatcher(std::move(automaton));
+}
+
+// Итог прогона: какие файлы результатов получили совпадения.
+void printSummary(const Options& options, bool kmpFound, bool acFound, bool queryFound) {
+    std::cout << "\nResults written to:\n";
+    if (kmpFound) {
+        std::cout << " - KMP results: " << KMP_RESULT_FILE << "\n";
+    } else {
+        std::cout << " - No KMP matches found.\n";
+    }
+
+    if (acFound) {
+        std::cout << " - Aho-Corasick results: " << AC_RESULT_FILE << "\n";
+    } else {
+        std::cout << " - No Aho-Corasick matches found.\n";
+    }
+
+    if (!options.query.empty()) {
+        if (queryFound) {
+            std::cout << " - Query results: " << QUERY_RESULT_FILE << "\n";
+        } else {
+            std::cout << " - No query matches found.\n";
+        }
+    }
+}
+
+// Результаты одного пакета записей конвейера — по буферу на файл.
+struct PipelineOutput {
+    std::string kmp;
+    std::string ac;
+    std::string query;
+};
+
+// Конвейерный режим (pipeline.hpp): файл не загружается целиком, каждый пакет
+// записей проходит KMP, Ахо–Корасик и запрос за один проход, а результаты пишутся,
+// пока следующие блоки ещё читаются. Заголовок файла результатов пишется с первым
+// совпадением, итоговое время в подвале — общее время прогона.
+void runPipelined(const Options& options, ProfileReport& report) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    ProfilePhase phase(report, "build");
+
+    // Длина полей заранее неизвестна: движки KMP выбираются только по шаблонам.
+    std::vector<SinglePattern> kmp;
+    for (const auto& pattern : KMP_PATTERNS) {
+        kmp.emplace_back(pattern, options.caseMode);
+    }
+    const PatternMatcher ac = buildAcMatcher(options);
+    std::optional<FieldQuery> query;
+    if (!options.query.empty()) {
+        query.emplace(options.query, options.caseMode);
+    }
+
+    ResultWriter kmpFile(KMP_RESULT_FILE);
+    ResultWriter acFile(AC_RESULT_FILE);
+    std::optional<ResultWriter> queryFile;
+    if (query) {
+        queryFile.emplace(QUERY_RESULT_FILE);
+    }
+    std::vector<SearchScratch> scratch(options.threads);
+    bool kmpFound = false;
+    bool acFound = false;
+    bool queryFound = false;
+    auto emit = [&](ResultWriter& file, bool& found, const std::string& bytes, const char* title) {
+        if (bytes.empty()) {
+            return;
+        }
+        if (!found) {
+            AppendHeader(file.buffer(), options.format, title);
+            found = true;
+        }
+        file.write(bytes);
+    };
+    phase.next("pipeline");
+
+    const PipelineStats stats = RunPipeline(
+        options.data, options.threads,
+        [&](size_t worker, const RecordBatch& batch) {
+            PipelineOutput out;
+            for (size_t i = 0; i < batch.records.size(); ++i) {
+                const RecordView v = batch.records[i];
+                const size_t line = batch.firstRecord + i + 1;
+                appendKmpMatches(out.kmp, options, kmp, line, v, scratch[worker]);
+                appendAcMatches(out.ac, options, ac, line, v, scratch[worker]);
+                if (query) {
+                    appendQueryMatch(out.query, options, *query, line, v, scratch[worker]);
+                }
+            }
+            return out;
+        },
+        [&](PipelineOutput&& out) {
+            emit(kmpFile, kmpFound, out.kmp, "KMP Search Results");
+            emit(acFile, acFound, out.ac, "Aho-Corasick Search Results");
+            if (queryFile) {
+                emit(*queryFile, queryFound, out.query, "Query Search Results");
+            }
+        });
 
-    if (!kmpFile.is_open() || !acFile.is_open()) {
-        throw std::runtime_error("Failed to open output files");
+    phase.next("write");
+    const auto end = std::chrono::high_resolution_clock::now();
+    const double total = std::chrono::duration<double, std::milli>(end - start).count();
+    if (kmpFound) {
+        AppendFooter(kmpFile.buffer(), options.format, total);
     }
+    if (acFound) {
+        AppendFooter(acFile.buffer(), options.format, total);
+    }
+    if (queryFound) {
+        AppendFooter(queryFile->buffer(), options.format, total);
+    }
+    kmpFile.close();
+    acFile.close();
+    if (queryFile) {
+        queryFile->close();
+    }
+    phase.finish();
+
+    // Занятость стадий: они работают одновременно, поэтому сумма больше времени
+    // фазы "pipeline"; поиск — сумма по рабочим потокам.
+    report.record("pipeline.read", stats.readMs);
+    report.record("pipeline.parse", stats.parseMs);
+    report.record("pipeline.search", stats.searchMs);
+    report.record("pipeline.write", stats.writeMs);
+    report.record("pipeline.first_result", stats.firstResultMs);
+
+    std::cout << "Pipeline: " << stats.blocks << " blocks, " << stats.records << " records, first result after "
+              << stats.firstResultMs << " ms, " << stats.totalMs << " ms total\n";
+    printSummary(options, kmpFound, acFound, queryFound);
+}
+
+// Пакетный режим: команды из options.batch выполняются по уже загруженному корпусу.
+void runBatch(const Options& options, const RecordStore& words, const SuffixIndex* index) {
+    std::ifstream file;
+    if (options.batch != "-") {
+        file.open(options.batch);
+        if (!file) {
+            throw std::runtime_error("Failed to open batch file: " + options.batch);
+        }
+    }
+    std::istream& in = options.batch == "-" ? std::cin : file;
+
+    ResultWriter results(BATCH_RESULT_FILE);
+    BatchRunner runner(words, options.threads, options.format, index);
+    const BatchRunner::Summary summary = runner.run(in, results, std::cout);
+    results.close();
+
+    std::cout << "\nBatch: " << summary.queries << " queries (" << summary.failed << " failed), "
+              << summary.matches << " matches, " << summary.totalMs << " ms total, p50 "
+              << BatchPercentile(summary.latencies, 0.50) << " ms, p99 " << BatchPercentile(summary.latencies, 0.99)
+              << " ms\nResults written to: " << BATCH_RESULT_FILE << "\n";
+}
 
-    // Загружаем данные из файла
-    std::vector<std::vector<std::string>> words = LinesWithWords(filename);
+int main(int argc, char* argv[]) {
+    const Options options = parseOptions(argc, argv);
+    const std::string& filename = options.data;
+    const size_t threads = options.threads;
+    ProfileReport report;
+    if (!options.phased && options.batch.empty() && options.saveIndex.empty() && options.loadIndex.empty()) {
+        runPipelined(options, report);
+        if (!options.profile.empty()) {
+            report.writeJson(options.profile);
+        }
+        return 0;
+    }
+
+    // Фазы идут подряд и меряются одним объектом; "search" включает форматирование
+    // результатов в буферы потоков, "write" — склейку буферов и запись в файл.
+    ProfilePhase phase(report, "load");
+
+    // Загружаем данные из файла: группы всех строк лежат в одной арене.
+    const MappedFile input(filename);
+    phase.next("split");
+    const RecordStore words = LinesWithWordsColumnar(input.view());
+
+    // Суффиксный индекс строится или загружается только по запросу.
+    std::optional<SuffixIndex> index;
+    if (!options.loadIndex.empty()) {
+        phase.next("load.index");
+        index.emplace(LoadSuffixIndex(options.loadIndex));
+        if (!index->matches(words)) {
+            throw std::runtime_error("Index does not match data file: " + options.loadIndex);
+        }
+    } else if (!options.saveIndex.empty()) {
+        phase.next("build.index");
+        index.emplace(words);
+    }
+    if (!options.saveIndex.empty()) {
+        phase.next("write.index");
+        SaveSuffixIndex(*index, options.saveIndex);
+    }
+
+    if (!options.batch.empty()) {
+        phase.next("batch");
+        runBatch(options, words, index ? &*index : nullptr);
+        phase.finish();
+        if (!options.profile.empty()) {
+            report.writeJson(options.profile);
+        }
+        return 0;
+    }
+    phase.next("build.kmp");
+
+    // Открываем файлы для записи результатов
+    ResultWriter kmpFile(KMP_RESULT_FILE);
+    ResultWriter acFile(AC_RESULT_FILE);
 
     // === ПОИСК С ИСПОЛЬЗОВАНИЕМ КМП ===
     auto startKMP = std::chrono::high_resolution_clock::now();
 
-    std::vector<std::string> kmp_patterns = {"2720", "628", "4", "Щ", "Я"}; // Пример паттернов
-    bool kmp_has_matches = false;
-
-    for (size_t i = 0; i < words.size(); ++i) {
-        const auto& v = words[i];
-        if (v.size() != 3) continue;
-
-        for (size_t j = 0; j < 3; ++j) {
-            for (const auto& pattern : kmp_patterns) {
-                size_t match_count = 0;
-                size_t* matches = kmp_search(v[j], pattern, &match_count);
-
-                if (match_count > 0) {
-                    if (!kmp_has_matches) {
-                        writeHeader(kmpFile, "KMP Search Results");
-                        kmp_has_matches = true;
-                    }
-
-                    for (size_t k = 0; k < match_count; ++k) {
-                        kmpFile << std::left << std::setw(10) << i + 1
-                                << std::setw(40) << v[j]
-                                << std::setw(20) << matches[k] << "\n";
-                    }
-                }
+    // Движок для каждого шаблона выбирается один раз (см. planner.hpp) по шаблону и
+    // средней длине поля, у каждого потока свои буферы.
+    const size_t field_length = words.bytes() / std::max<size_t>(words.size() * RecordView::size(), 1);
+    std::vector<SinglePattern> kmp_compiled;
+    for (const auto& pattern : KMP_PATTERNS) {
+        kmp_compiled.emplace_back(pattern, options.caseMode, field_length);
+    }
+    phase.next("search.kmp");
+    std::vector<SearchScratch> scratch(threads);
+    OrderedBuffers kmpOut(threads);
 
-                free(matches);
-            }
+    ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                   [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+        std::string& out = kmpOut.begin(worker, chunk);
+        for (size_t i = begin; i < end; ++i) {
+            appendKmpMatches(out, options, kmp_compiled, i + 1, words[i], scratch[worker]);
         }
+        kmpOut.end(worker);
+    });
+
+    phase.next("write.kmp");
+    const bool kmp_has_matches = !kmpOut.empty();
+    if (kmp_has_matches) {
+        AppendHeader(kmpFile.buffer(), options.format, "KMP Search Results");
+        kmpOut.forEachInOrder([&](std::string_view bytes) { kmpFile.write(bytes); });
     }
 
     auto endKMP = std::chrono::high_resolution_clock::now();
@@ -79,35 +432,33 @@ int main() {
 
     // Добавляем время выполнения в файл, только если были найдены совпадения
     if (kmp_has_matches) {
-        writeFooter(kmpFile, timeKMP);
+        AppendFooter(kmpFile.buffer(), options.format, timeKMP);
     }
 
     kmpFile.close();
 
     // === ПОИСК С ИСПОЛЬЗОВАНИЕМ АХО-КОРАСИКА ===
+    phase.next("build.ac");
     auto startAC = std::chrono::high_resolution_clock::now();
 
-    std::vector<std::string> aho_patterns = {"6", "2", "8", "7"}; // Пример паттернов
-    bool ac_has_matches = false;
-
-    for (size_t i = 0; i < words.size(); ++i) {
-        const auto& v = words[i];
-        if (v.size() != 3) continue;
-
-        for (size_t j = 0; j < 3; ++j) {
-            bool all_found = AhoSearch(v[j], aho_patterns, aho_patterns.size());
-
-            if (all_found) {
-                if (!ac_has_matches) {
-                    writeHeader(acFile, "Aho-Corasick Search Results");
-                    ac_has_matches = true;
-                }
+    const PatternMatcher ac = buildAcMatcher(options);
+    OrderedBuffers acOut(threads);
+    phase.next("search.ac");
 
-                acFile << std::left << std::setw(10) << i + 1
-                        << std::setw(40) << v[j]
-                        << std::setw(20) << "All patterns found\n";
-            }
+    ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                   [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+        std::string& out = acOut.begin(worker, chunk);
+        for (size_t i = begin; i < end; ++i) {
+            appendAcMatches(out, options, ac, i + 1, words[i], scratch[worker]);
         }
+        acOut.end(worker);
+    });
+
+    phase.next("write.ac");
+    const bool ac_has_matches = !acOut.empty();
+    if (ac_has_matches) {
+        AppendHeader(acFile.buffer(), options.format, "Aho-Corasick Search Results");
+        acOut.forEachInOrder([&](std::string_view bytes) { acFile.write(bytes); });
     }
 
     auto endAC = std::chrono::high_resolution_clock::now();
@@ -115,23 +466,54 @@ int main() {
 
     // Добавляем время выполнения в файл, только если были найдены совпадения
     if (ac_has_matches) {
-        writeFooter(acFile, timeAC);
+        AppendFooter(acFile.buffer(), options.format, timeAC);
     }
 
     acFile.close();
+    phase.finish();
 
-    std::cout << "\nResults written to:\n";
-    if (kmp_has_matches) {
-        std::cout << " - KMP results: " << KMP_RESULT_FILE << "\n";
-    } else {
-        std::cout << " - No KMP matches found.\n";
+    // === ПОИСК ПО ЗАПРОСУ ===
+    // Все поля строки проверяются одним автоматом за один проход.
+    bool query_has_matches = false;
+    if (!options.query.empty()) {
+        auto startQuery = std::chrono::high_resolution_clock::now();
+
+        phase.next("build.query");
+        const FieldQuery query(options.query, options.caseMode);
+        ResultWriter queryFile(QUERY_RESULT_FILE);
+        OrderedBuffers queryOut(threads);
+        phase.next("search.query");
+
+        ParallelChunks(words.size(), threads, LINES_PER_CHUNK,
+                       [&](size_t worker, size_t chunk, size_t begin, size_t end) {
+            std::string& out = queryOut.begin(worker, chunk);
+            for (size_t i = begin; i < end; ++i) {
+                appendQueryMatch(out, options, query, i + 1, words[i], scratch[worker]);
+            }
+            queryOut.end(worker);
+        });
+
+        phase.next("write.query");
+        query_has_matches = !queryOut.empty();
+        if (query_has_matches) {
+            AppendHeader(queryFile.buffer(), options.format, "Query Search Results");
+            queryOut.forEachInOrder([&](std::string_view bytes) { queryFile.write(bytes); });
+        }
+
+        auto endQuery = std::chrono::high_resolution_clock::now();
+        double timeQuery = std::chrono::duration<double, std::milli>(endQuery - startQuery).count();
+        if (query_has_matches) {
+            AppendFooter(queryFile.buffer(), options.format, timeQuery);
+        }
+        queryFile.close();
+        phase.finish();
     }
 
-    if (ac_has_matches) {
-        std::cout << " - Aho-Corasick results: " << AC_RESULT_FILE << "\n";
-    } else {
-        std::cout << " - No Aho-Corasick matches found.\n";
+    if (!options.profile.empty()) {
+        report.writeJson(options.profile);
     }
 
+    printSummary(options, kmp_has_matches, ac_has_matches, query_has_matches);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,373 @@
+// ============================================================================
+// Данный заголовочный файл содержит вывод результатов поиска: форматирование
+// записей в буфер без iostream и запись файла крупными блоками.
+// ============================================================================
+
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LAB_HAVE_POSIX_IO 1
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define LAB_HAVE_POSIX_IO 0
+#endif
+
+// Логика вывода:
+// 1. Каждая найденная позиция описывается записью MatchRecord: номер строки (с 1),
+//    номер поля, смещение, индекс шаблона и сам текст поля.
+// 2. AppendMatch дописывает запись в обычную строку-буфер: числа — через
+//    std::to_chars, выравнивание — дописыванием пробелов. Состояния потока
+//    (setw, left) нет, поэтому один буфер можно переиспользовать без сбросов.
+// 3. ResultWriter копит байты в большом буфере и сбрасывает его в файл одним
+//    вызовом write(2), когда буфер заполнен.
+//
+// Форматы:
+//   Table  — таблица как раньше (writeHeader/writeFooter, колонки 10/40/20);
+//   Tsv    — line, field, offset, pattern, data через табуляцию;
+//   Json   — JSON Lines, один объект на запись;
+//   Binary — заголовок "LABR" + версия, затем записи по 24 байта:
+//            line (u64), field (u32), pattern (u32), offset (u64), порядок байт — родной.
+// Запись "все шаблоны найдены" (поиск Ахо–Корасик) имеет pattern = ALL_PATTERNS, а
+// строка, подошедшая под запрос (query.hpp), — pattern = QUERY_MATCH; у обеих offset = 0,
+// в Tsv/Json их pattern выводится как -1.
+//
+// Приближённые вхождения (approx.hpp) пишутся под заголовком MatchKind::Approximate:
+// offset — позиция сразу за концом вхождения, а расстояние — отдельная колонка.
+//   Table  — "end N, distance K" в колонке Match Index;
+//   Tsv    — line, field, end, pattern, distance, data;
+//   Json   — "end" и "distance" вместо "offset";
+//   Binary — заголовок "LABA" + версия, записи по 32 байта: line (u64), field (u32),
+//            pattern (u32), end (u64), distance (u32), 4 байта нулей.
+
+// ========================================================================
+// | AppendHeader | AppendMatch | AppendFooter | ResultWriter(path).write |
+// ========================================================================
+
+enum class ResultFormat { Table, Tsv, Json, Binary };
+
+// Вид записей под заголовком: точные вхождения (offset — начало) или приближённые
+// (offset — конец, есть расстояние).
+enum class MatchKind { Exact, Approximate };
+
+inline constexpr uint32_t ALL_PATTERNS = UINT32_MAX;
+inline constexpr uint32_t QUERY_MATCH = UINT32_MAX - 1;
+inline constexpr uint32_t BINARY_RESULT_VERSION = 1;
+inline constexpr uint32_t NO_DISTANCE = UINT32_MAX;
+
+struct MatchRecord {
+    uint64_t line;
+    uint32_t field;
+    uint64_t offset;
+    uint32_t pattern;
+    std::string_view data;
+    // Только для приближённых вхождений: число замен или правок.
+    uint32_t distance = NO_DISTANCE;
+};
+
+[[nodiscard]] inline ResultFormat ParseResultFormat(std::string_view name) {
+    if (name == "table") return ResultFormat::Table;
+    if (name == "tsv") return ResultFormat::Tsv;
+    if (name == "jsonl") return ResultFormat::Json;
+    if (name == "binary") return ResultFormat::Binary;
+    throw std::invalid_argument("Unknown result format: " + std::string(name));
+}
+
+// Дописывает s и добивает пробелами до width байт (как std::left << std::setw(width)).
+inline void AppendPadded(std::string& out, std::string_view s, size_t width) {
+    out.append(s.data(), s.size());
+    if (s.size() < width) {
+        out.append(width - s.size(), ' ');
+    }
+}
+
+inline void AppendNumber(std::string& out, uint64_t value, size_t width = 0) {
+    char digits[24];
+    const auto res = std::to_chars(digits, digits + sizeof(digits), value);
+    AppendPadded(out, std::string_view(digits, static_cast<size_t>(res.ptr - digits)), width);
+}
+
+inline void AppendJsonString(std::string& out, std::string_view s) {
+    out += '"';
+    for (const char c : s) {
+        const auto b = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (b < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out += "\\u00";
+            out += hex[b >> 4];
+            out += hex[b & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+template <typename T>
+inline void AppendRaw(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+inline void AppendHeader(std::string& out, ResultFormat format, std::string_view title,
+                         MatchKind kind = MatchKind::Exact) {
+    const bool approximate = kind == MatchKind::Approximate;
+    switch (format) {
+        case ResultFormat::Table:
+            out += "===========================================\n";
+            out += title;
+            out += "\n-------------------------------------------\n";
+            AppendPadded(out, "Line", 10);
+            AppendPadded(out, "Data", 40);
+            AppendPadded(out, "Match Index\n", 20);
+            out += "-------------------------------------------\n";
+            break;
+        case ResultFormat::Tsv:
+            out += approximate ? "line\tfield\tend\tpattern\tdistance\tdata\n"
+                               : "line\tfield\toffset\tpattern\tdata\n";
+            break;
+        case ResultFormat::Json:
+            break;
+        case ResultFormat::Binary:
+            out += approximate ? "LABA" : "LABR";
+            AppendRaw(out, BINARY_RESULT_VERSION);
+            break;
+    }
+}
+
+inline void AppendMatch(std::string& out, ResultFormat format, const MatchRecord& r) {
+    switch (format) {
+        case ResultFormat::Table:
+            AppendNumber(out, r.line, 10);
+            AppendPadded(out, r.data, 40);
+            if (r.pattern == ALL_PATTERNS) {
+                AppendPadded(out, "All patterns found\n", 20);
+            } else if (r.pattern == QUERY_MATCH) {
+                AppendPadded(out, "Query matched\n", 20);
+            } else if (r.distance != NO_DISTANCE) {
+                out += "end ";
+                AppendNumber(out, r.offset);
+                out += ", distance ";
+                AppendNumber(out, r.distance);
+                out += '\n';
+            } else {
+                AppendNumber(out, r.offset, 20);
+                out += '\n';
+            }
+            break;
+        case ResultFormat::Tsv:
+            AppendNumber(out, r.line);
+            out += '\t';
+            AppendNumber(out, r.field);
+            out += '\t';
+            AppendNumber(out, r.offset);
+            out += '\t';
+            if (r.pattern >= QUERY_MATCH) {
+                out += "-1";
+            } else {
+                AppendNumber(out, r.pattern);
+            }
+            out += '\t';
+            if (r.distance != NO_DISTANCE) {
+                AppendNumber(out, r.distance);
+                out += '\t';
+            }
+            out += r.data;
+            out += '\n';
+            break;
+        case ResultFormat::Json:
+            out += "{\"line\":";
+            AppendNumber(out, r.line);
+            out += ",\"field\":";
+            AppendNumber(out, r.field);
+            out += r.distance != NO_DISTANCE ? ",\"end\":" : ",\"offset\":";
+            AppendNumber(out, r.offset);
+            if (r.distance != NO_DISTANCE) {
+                out += ",\"distance\":";
+                AppendNumber(out, r.distance);
+            }
+            out += ",\"pattern\":";
+            if (r.pattern >= QUERY_MATCH) {
+                out += "-1";
+            } else {
+                AppendNumber(out, r.pattern);
+            }
+            out += ",\"data\":";
+            AppendJsonString(out, r.data);
+            out += "}\n";
+            break;
+        case ResultFormat::Binary:
+            AppendRaw<uint64_t>(out, r.line);
+            AppendRaw<uint32_t>(out, r.field);
+            AppendRaw<uint32_t>(out, r.pattern);
+            AppendRaw<uint64_t>(out, r.offset);
+            if (r.distance != NO_DISTANCE) {
+                AppendRaw<uint32_t>(out, r.distance);
+                AppendRaw<uint32_t>(out, 0);
+            }
+            break;
+    }
+}
+
+inline void AppendFooter(std::string& out, ResultFormat format, double time_ms) {
+    char digits[32];
+    const auto res = std::to_chars(digits, digits + sizeof(digits), time_ms, std::chars_format::general, 6);
+    const std::string_view time(digits, static_cast<size_t>(res.ptr - digits));
+
+    switch (format) {
+        case ResultFormat::Table:
+            out += "-------------------------------------------\n";
+            out += "Execution time: ";
+            out += time;
+            out += " ms\n";
+            out += "===========================================\n\n";
+            break;
+        case ResultFormat::Tsv:
+            out += "# execution_time_ms\t";
+            out += time;
+            out += '\n';
+            break;
+        case ResultFormat::Json:
+            out += "{\"execution_time_ms\":";
+            out += time;
+            out += "}\n";
+            break;
+        case ResultFormat::Binary:
+            break;
+    }
+}
+
+// Класс ResultWriter пишет файл блоками по FLUSH_SIZE байт и больше.
+// Данные можно дописывать напрямую в buffer() и затем вызвать commit(),
+// либо передать готовый кусок в write().
+class ResultWriter {
+public:
+    static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+    explicit ResultWriter(const std::string& path) : path_(path) {
+#if LAB_HAVE_POSIX_IO
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open output file: " + path);
+        }
+#else
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            throw std::runtime_error("Failed to open output file: " + path);
+        }
+#endif
+        buffer_.reserve(FLUSH_SIZE * 2);
+    }
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    ~ResultWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    [[nodiscard]] std::string& buffer() { return buffer_; }
+
+    void commit() {
+        if (buffer_.size() >= FLUSH_SIZE) {
+            flush();
+        }
+    }
+
+    void write(std::string_view bytes) {
+        if (buffer_.empty() && bytes.size() >= FLUSH_SIZE) {
+            writeAll(bytes);
+            return;
+        }
+        buffer_.append(bytes.data(), bytes.size());
+        commit();
+    }
+
+    void flush() {
+        writeAll(buffer_);
+        buffer_.clear();
+    }
+
+    // Файл закрывается и тогда, когда запись остатка буфера не удалась: ошибка записи
+    // пробрасывается после закрытия, а ошибка самого закрытия — отдельным исключением.
+    void close() {
+#if LAB_HAVE_POSIX_IO
+        if (fd_ < 0) {
+            return;
+        }
+        try {
+            flush();
+        } catch (...) {
+            ::close(fd_);
+            fd_ = -1;
+            throw;
+        }
+        const int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) {
+            throw std::runtime_error("Failed to close output file: " + path_);
+        }
+#else
+        if (!file_.is_open()) {
+            return;
+        }
+        try {
+            flush();
+        } catch (...) {
+            file_.close();
+            throw;
+        }
+        file_.close();
+        if (!file_) {
+            throw std::runtime_error("Failed to close output file: " + path_);
+        }
+#endif
+    }
+
+private:
+    std::string path_;
+    std::string buffer_;
+#if LAB_HAVE_POSIX_IO
+    int fd_ = -1;
+#else
+    std::ofstream file_;
+#endif
+
+    void writeAll(std::string_view bytes) {
+#if LAB_HAVE_POSIX_IO
+        while (!bytes.empty()) {
+            const ssize_t n = ::write(fd_, bytes.data(), bytes.size());
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to write output file: " + path_);
+            }
+            bytes.remove_prefix(static_cast<size_t>(n));
+        }
+#else
+        if (!file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+            throw std::runtime_error("Failed to write output file: " + path_);
+        }
+#endif
+    }
+};
+
+#endif // OUTPUT_HPP
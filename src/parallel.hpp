@@ -0,0 +1,227 @@
+// ============================================================================
+// Данный заголовочный файл содержит простой планировщик для параллельной
+// обработки диапазона строк и буферы для упорядоченного вывода результатов.
+// ============================================================================
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Логика планировщика:
+// 1. Диапазон [0, count) делится на куски (chunks) по chunkSize элементов.
+// 2. Каждый поток получает свою непрерывную очередь кусков и берёт их с начала.
+// 3. Поток, у которого кусков не осталось, ворует половину очереди другого потока
+//    с конца (work stealing). Очередь — пара индексов (lo, hi), упакованная в один
+//    atomic<uint64_t>, поэтому и взятие, и кража — одна операция compare_exchange.
+//
+// Так как куски после кражи обрабатываются не по порядку, каждый поток пишет вывод
+// в свой буфер и запоминает, какой кусок где лежит (OrderedBuffers). После завершения
+// сегменты склеиваются по номеру куска — результат совпадает с последовательным.
+
+// ===================================================================
+// | ParallelChunks(count, threads, chunkSize, body) | OrderedBuffers |
+// ===================================================================
+
+[[nodiscard]] inline size_t DefaultThreadCount() {
+    const unsigned hc = std::thread::hardware_concurrency();
+    return hc == 0 ? 1 : hc;
+}
+
+class ChunkQueue {
+public:
+    void reset(uint32_t lo, uint32_t hi) {
+        range.store(pack(lo, hi), std::memory_order_release);
+    }
+
+    // Владелец берёт кусок с начала очереди.
+    bool pop(uint32_t& chunk) {
+        uint64_t cur = range.load(std::memory_order_acquire);
+        while (lo(cur) < hi(cur)) {
+            if (range.compare_exchange_weak(cur, pack(lo(cur) + 1, hi(cur)), std::memory_order_acq_rel)) {
+                chunk = lo(cur);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Вор забирает с конца очереди половину оставшихся кусков: [from, to).
+    bool steal(uint32_t& from, uint32_t& to) {
+        uint64_t cur = range.load(std::memory_order_acquire);
+        while (lo(cur) < hi(cur)) {
+            const uint32_t mid = lo(cur) + (hi(cur) - lo(cur)) / 2;
+            if (range.compare_exchange_weak(cur, pack(lo(cur), mid), std::memory_order_acq_rel)) {
+                from = mid;
+                to = hi(cur);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::atomic<uint64_t> range{0};
+
+    static uint64_t pack(uint32_t l, uint32_t h) { return (static_cast<uint64_t>(h) << 32) | l; }
+    static uint32_t lo(uint64_t v) { return static_cast<uint32_t>(v); }
+    static uint32_t hi(uint64_t v) { return static_cast<uint32_t>(v >> 32); }
+};
+
+// Функция ParallelChunks вызывает body(worker, chunk, begin, end) для каждого куска
+// [begin, end) диапазона [0, count). worker — номер потока в [0, threads), его удобно
+// использовать как индекс потоковых буферов. Поток 0 — вызывающий. Первое исключение,
+// выброшенное из body, пробрасывается после завершения всех потоков.
+template <typename Body>
+void ParallelChunks(size_t count, size_t threads, size_t chunkSize, Body&& body) {
+    if (count == 0) {
+        return;
+    }
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    const size_t chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunks > UINT32_MAX) {
+        throw std::length_error("ParallelChunks: too many chunks");
+    }
+    threads = std::clamp<size_t>(threads, 1, chunks);
+
+    if (threads == 1) {
+        for (size_t c = 0; c < chunks; ++c) {
+            body(size_t{0}, c, c * chunkSize, std::min(count, (c + 1) * chunkSize));
+        }
+        return;
+    }
+
+    std::vector<ChunkQueue> queues(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        queues[t].reset(static_cast<uint32_t>(chunks * t / threads),
+                        static_cast<uint32_t>(chunks * (t + 1) / threads));
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::atomic<bool> failed{false};
+
+    auto worker = [&](size_t self) {
+        try {
+            for (;;) {
+                uint32_t chunk;
+                while (!failed.load(std::memory_order_relaxed) && queues[self].pop(chunk)) {
+                    const size_t begin = static_cast<size_t>(chunk) * chunkSize;
+                    body(self, static_cast<size_t>(chunk), begin, std::min(count, begin + chunkSize));
+                }
+                if (failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                bool stolen = false;
+                for (size_t k = 1; k < threads && !stolen; ++k) {
+                    uint32_t from, to;
+                    if (queues[(self + k) % threads].steal(from, to)) {
+                        queues[self].reset(from, to);
+                        stolen = true;
+                    }
+                }
+                if (!stolen) {
+                    return;
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Класс OrderedBuffers хранит по одному буферу вывода на поток. Вывод куска
+// обрамляется вызовами begin/end, после чего forEachInOrder (или writeTo) отдаёт
+// все сегменты в порядке номеров кусков. Буферы — обычные строки: записи в них
+// дописываются без потоков ввода-вывода и без копирования при склейке.
+class OrderedBuffers {
+public:
+    explicit OrderedBuffers(size_t workers) : buffers(workers), segments(workers) {}
+
+    std::string& begin(size_t worker, size_t chunk) {
+        const size_t pos = buffers[worker].size();
+        segments[worker].push_back(Segment{chunk, pos, pos});
+        return buffers[worker];
+    }
+
+    void end(size_t worker) {
+        segments[worker].back().end = buffers[worker].size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        for (const auto& list : segments) {
+            for (const auto& s : list) {
+                if (s.begin != s.end) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Вызывает fn(std::string_view) для каждого непустого сегмента по порядку кусков.
+    template <typename Fn>
+    void forEachInOrder(Fn&& fn) const {
+        std::vector<std::pair<size_t, const Segment*>> order;
+        for (size_t w = 0; w < buffers.size(); ++w) {
+            for (const auto& s : segments[w]) {
+                if (s.begin != s.end) {
+                    order.emplace_back(w, &s);
+                }
+            }
+        }
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            return a.second->chunk < b.second->chunk;
+        });
+        for (const auto& [w, s] : order) {
+            fn(std::string_view(buffers[w].data() + s->begin, s->end - s->begin));
+        }
+    }
+
+    void writeTo(std::ostream& out) const {
+        forEachInOrder([&out](std::string_view bytes) {
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        });
+    }
+
+private:
+    struct Segment {
+        size_t chunk;
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<std::string> buffers;
+    std::vector<std::vector<Segment>> segments;
+};
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,383 @@
+// ============================================================================
+// Данный заголовочный файл содержит конвейер чтение -> разбор -> поиск -> запись:
+// стадии работают одновременно и связаны ограниченными очередями без блокировок.
+// ============================================================================
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "file.hpp"
+#include "records.hpp"
+
+// Стадии:
+// 1. Чтение — файл читается блоками по PIPELINE_BLOCK_SIZE байт (ChunkReader);
+//    блок обрезается по последнему '\n', хвост переносится в следующий блок, так что
+//    каждый блок — целые строки.
+// 2. Разбор — блок разбирается в RecordStore (LinesWithWordsColumnar); разборщик
+//    один, поэтому он же нумерует записи сквозь весь файл (firstRecord).
+// 3. Поиск — threads рабочих потоков берут готовые пакеты записей и прогоняют по
+//    каждому все поиски за один проход (search(worker, batch) -> Output).
+// 4. Запись — вызывающий поток получает результаты пакетов, восстанавливает порядок
+//    по номеру пакета и отдаёт их write(output) строго по порядку.
+//
+// Очереди и обратное давление:
+// Стадии связаны очередями BoundedQueue фиксированной ёмкости (алгоритм Вьюкова:
+// номер-последовательность в каждой ячейке, одна операция compare_exchange на
+// вставку или извлечение). Поток, упёршийся в полную или пустую очередь, крутится
+// с уступкой процессора (std::this_thread::yield), мьютексов нет. Кроме того,
+// разборщик не выпускает пакет, пока с последнего записанного в файл пакета не
+// прошло меньше maxInFlight номеров: медленный пакет не даёт остальным копиться в
+// буфере перестановки писателя. Поэтому в памяти одновременно находится не больше
+// maxInFlight пакетов и ёмкость очередей блоков — память и время до первого
+// результата не зависят от размера файла.
+//
+// Ошибки: первое исключение любой стадии останавливает все очереди, потоки
+// завершаются, и исключение пробрасывается из RunPipeline.
+
+// =========================================================================
+// | BoundedQueue<T>(capacity).push/pop/close/abort                        |
+// | RunPipeline(filename, threads, search, write) -> PipelineStats        |
+// =========================================================================
+
+inline constexpr size_t PIPELINE_BLOCK_SIZE = 64 << 10;
+
+// Класс BoundedQueue — ограниченная очередь для нескольких производителей и
+// потребителей. Ёмкость округляется вверх до степени двойки.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        cells = std::vector<Cell>(size);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Неблокирующая вставка: false, если очередь полна (value не тронут).
+    bool tryPush(T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Неблокирующее извлечение: false, если очередь пуста.
+    bool tryPop(T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Вставка с ожиданием места. false — очередь остановлена (abort), значение не вставлено.
+    bool push(T value) {
+        for (size_t spins = 0; !tryPush(value); ++spins) {
+            if (aborted.load(std::memory_order_acquire)) {
+                return false;
+            }
+            Backoff(spins);
+        }
+        return true;
+    }
+
+    // Извлечение с ожиданием. false — очередь закрыта и пуста, либо остановлена.
+    bool pop(T& value) {
+        for (size_t spins = 0;; ++spins) {
+            if (tryPop(value)) {
+                return true;
+            }
+            if (aborted.load(std::memory_order_acquire)) {
+                return false;
+            }
+            // После close новых элементов не будет; последняя попытка забирает то,
+            // что успели вставить до закрытия.
+            if (closed.load(std::memory_order_acquire)) {
+                return tryPop(value);
+            }
+            Backoff(spins);
+        }
+    }
+
+    // Производители закончили: pop вернёт false, когда очередь опустеет.
+    void close() { closed.store(true, std::memory_order_release); }
+
+    // Остановка из-за ошибки: push и pop сразу возвращают false.
+    void abort() { aborted.store(true, std::memory_order_release); }
+
+    // Несколько десятков холостых проверок, затем уступка процессора.
+    static void Backoff(size_t spins) {
+        if (spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    // head и tail на разных строках кэша: производители и потребители не мешают друг другу.
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::vector<Cell> cells;
+    size_t mask = 0;
+    std::atomic<bool> closed{false};
+    std::atomic<bool> aborted{false};
+};
+
+// Пакет записей для стадии поиска: записи одного блока и номер первой из них в файле.
+struct RecordBatch {
+    size_t firstRecord = 0;
+    RecordStore records;
+};
+
+// Статистика прогона: занятость стадий (поиск — сумма по рабочим потокам), время до
+// первой записи результата и общее время.
+struct PipelineStats {
+    size_t blocks = 0;
+    size_t records = 0;
+    double readMs = 0;
+    double parseMs = 0;
+    double searchMs = 0;
+    double writeMs = 0;
+    double firstResultMs = 0;
+    double totalMs = 0;
+};
+
+// Функция RunPipeline прогоняет файл через стадии: search(worker, batch) вызывается
+// в рабочих потоках (worker в [0, threads)) и возвращает результат пакета, а
+// write(std::move(result)) вызывается в вызывающем потоке по порядку пакетов.
+template <typename Search, typename Write>
+PipelineStats RunPipeline(const std::string& filename, size_t threads, Search&& search, Write&& write) {
+    using Output = std::invoke_result_t<Search&, size_t, const RecordBatch&>;
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = [](Clock::time_point from) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - from).count();
+    };
+
+    struct Block {
+        size_t sequence = 0;
+        std::string bytes;
+    };
+    struct Batch {
+        size_t sequence = 0;
+        RecordBatch batch;
+    };
+    struct Result {
+        size_t sequence = 0;
+        Output output{};
+    };
+
+    threads = std::max<size_t>(threads, 1);
+    const size_t capacity = 2 * threads;
+    const size_t maxInFlight = 4 * threads;
+    BoundedQueue<Block> blocks(capacity);
+    BoundedQueue<Batch> batches(capacity);
+    BoundedQueue<Result> results(capacity);
+
+    PipelineStats stats;
+    const Clock::time_point started = Clock::now();
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> activeWorkers{threads};
+    std::vector<double> searchMs(threads, 0);
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::atomic<bool> failed{false};
+    auto fail = [&] {
+        failed.store(true, std::memory_order_release);
+        {
+            const std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        blocks.abort();
+        batches.abort();
+        results.abort();
+    };
+
+    std::thread reader([&] {
+        try {
+            ChunkReader file(filename, PIPELINE_BLOCK_SIZE);
+            std::string pending;
+            std::string_view chunk;
+            size_t sequence = 0;
+            Clock::time_point busy = Clock::now();
+            while (file.next(chunk)) {
+                pending.append(chunk.data(), chunk.size());
+                const size_t cut = pending.rfind('\n');
+                if (cut == std::string::npos) {
+                    continue;
+                }
+                Block block{sequence++, std::move(pending)};
+                pending.assign(block.bytes, cut + 1, std::string::npos);
+                block.bytes.resize(cut + 1);
+                stats.readMs += elapsed(busy);
+                if (!blocks.push(std::move(block))) {
+                    return;
+                }
+                busy = Clock::now();
+            }
+            if (!pending.empty()) {
+                stats.readMs += elapsed(busy);
+                if (!blocks.push(Block{sequence++, std::move(pending)})) {
+                    return;
+                }
+            }
+            stats.blocks = sequence;
+            blocks.close();
+        } catch (...) {
+            fail();
+        }
+    });
+
+    std::thread parser([&] {
+        try {
+            Block block;
+            size_t records = 0;
+            while (blocks.pop(block)) {
+                const Clock::time_point busy = Clock::now();
+                Batch batch{block.sequence, RecordBatch{records, LinesWithWordsColumnar(block.bytes)}};
+                records += batch.batch.records.size();
+                stats.parseMs += elapsed(busy);
+                // Обратное давление от писателя: не больше maxInFlight пакетов между
+                // разборщиком и файлом результатов.
+                for (size_t spins = 0; batch.sequence >= written.load(std::memory_order_acquire) + maxInFlight;
+                     ++spins) {
+                    if (failed.load(std::memory_order_acquire)) {
+                        return;
+                    }
+                    BoundedQueue<Batch>::Backoff(spins);
+                }
+                if (!batches.push(std::move(batch))) {
+                    return;
+                }
+            }
+            stats.records = records;
+            batches.close();
+        } catch (...) {
+            fail();
+        }
+    });
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w] {
+            try {
+                Batch batch;
+                while (batches.pop(batch)) {
+                    const Clock::time_point busy = Clock::now();
+                    Result result{batch.sequence, search(w, static_cast<const RecordBatch&>(batch.batch))};
+                    searchMs[w] += elapsed(busy);
+                    if (!results.push(std::move(result))) {
+                        return;
+                    }
+                }
+                // Последний завершившийся рабочий поток закрывает очередь результатов.
+                if (activeWorkers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    results.close();
+                }
+            } catch (...) {
+                fail();
+            }
+        });
+    }
+
+    // Писатель: пакеты приходят не по порядку, но номер любого из них меньше
+    // written + maxInFlight, поэтому буфера перестановки на maxInFlight мест хватает.
+    try {
+        std::vector<std::optional<Output>> reorder(maxInFlight);
+        Result result;
+        while (results.pop(result)) {
+            reorder[result.sequence % maxInFlight] = std::move(result.output);
+            for (;;) {
+                const size_t next = written.load(std::memory_order_relaxed);
+                std::optional<Output>& slot = reorder[next % maxInFlight];
+                if (!slot) {
+                    break;
+                }
+                const Clock::time_point busy = Clock::now();
+                write(std::move(*slot));
+                slot.reset();
+                stats.writeMs += elapsed(busy);
+                if (next == 0) {
+                    stats.firstResultMs = elapsed(started);
+                }
+                written.store(next + 1, std::memory_order_release);
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+
+    reader.join();
+    parser.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    for (const double ms : searchMs) {
+        stats.searchMs += ms;
+    }
+    stats.totalMs = elapsed(started);
+    return stats;
+}
+
+#endif // PIPELINE_HPP
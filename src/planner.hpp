@@ -0,0 +1,364 @@
+// ============================================================================
+// Данный заголовочный файл содержит планировщик поиска одного шаблона: по шаблону
+// выбирается memchr, Хорспул, Two-Way или KMP, все — за одним интерфейсом.
+// ============================================================================
+
+#ifndef PLANNER_HPP
+#define PLANNER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "casefold.hpp"
+#include "kmp.hpp"
+#include "simd.hpp"
+
+// Движки:
+// 1. Memchr — шаблон из одного байта: вхождение — сам байт, его ищет memchr
+//    (в стандартной библиотеке он векторизован).
+// 2. Horspool — сдвиг по последнему байту окна: таблица на 256 байт говорит, на
+//    сколько можно сдвинуть окно, если этот байт не завершает вхождение. На длинных
+//    шаблонах из разных байт окно прыгает почти на длину шаблона, но на шаблонах из
+//    повторяющихся байт (например, "0000") худший случай — O(n * m).
+// 3. TwoWay — алгоритм Крошмора–Перрена: шаблон делится в критической точке,
+//    правая часть сравнивается слева направо, левая — справа налево, а сдвиг берётся
+//    из периода шаблона. Линейное время в худшем случае и O(1) дополнительной памяти.
+// 4. Kmp — KmpPattern (kmp.hpp): запасной вариант, в том числе единственный движок,
+//    который умеет искать без учёта регистра.
+// На длинных текстах Horspool, TwoWay и Kmp сначала отбирают позиции одним и тем же
+// SIMD-префильтром по крайним байтам шаблона (simd.hpp), и скорость там почти не
+// зависит от движка; движок решает на коротких текстах (полях data.txt, в среднем
+// 5–10 байт) и там, где префильтр сдаётся.
+//
+// План (PlanSingleSearch) строится один раз при создании SinglePattern:
+// - без учёта регистра или пустой шаблон — Kmp;
+// - один байт — Memchr;
+// - периодичный шаблон (период не больше половины длины) или шаблон, почти целиком
+//   из одного байта, — TwoWay, если тексты длинные или их длина неизвестна: для
+//   Хорспула это худший случай O(n * m). В коротком тексте он ограничен длиной
+//   текста, и Хорспул остаётся быстрее;
+// - остальные — Horspool: на полях data.txt он вдвое быстрее KMP.
+// Все движки возвращают одни и те же позиции — начала всех, в том числе
+// перекрывающихся, вхождений по возрастанию.
+
+// ==================================================================
+// | SinglePattern(string pattern).search(text, callback)          |
+// | SinglePattern(string pattern).search(text, matches)           |
+// | PlanSingleSearch(pattern, mode, expectedText) -> SingleEngine |
+// ==================================================================
+
+enum class SingleEngine { Memchr, Horspool, TwoWay, Kmp };
+
+// Ожидаемая длина текста неизвестна.
+inline constexpr size_t UNKNOWN_TEXT_LENGTH = 0;
+// Тексты короче этого считаются короткими: SIMD-префильтр по крайним байтам на них
+// не включается (тот же порог, что у KmpPattern).
+inline constexpr size_t SHORT_TEXT_LENGTH = 32;
+
+[[nodiscard]] inline const char* SingleEngineName(SingleEngine engine) {
+    switch (engine) {
+        case SingleEngine::Memchr: return "memchr";
+        case SingleEngine::Horspool: return "Horspool";
+        case SingleEngine::TwoWay: return "Two-Way";
+        default: return "KMP";
+    }
+}
+
+// Наименьший период шаблона: m - (длина наибольшей грани).
+[[nodiscard]] inline size_t PatternPeriod(std::string_view pattern) {
+    size_t border = 0;
+    std::vector<size_t> pie(pattern.size());
+    for (size_t i = 1; i < pattern.size(); ++i) {
+        while (border > 0 && pattern[border] != pattern[i]) {
+            border = pie[border - 1];
+        }
+        if (pattern[border] == pattern[i]) {
+            ++border;
+        }
+        pie[i] = border;
+    }
+    return pattern.size() - (pattern.empty() ? 0 : pie.back());
+}
+
+[[nodiscard]] inline SingleEngine PlanSingleSearch(std::string_view pattern, CaseMode mode,
+                                                   size_t expectedText = UNKNOWN_TEXT_LENGTH) {
+    const size_t m = pattern.size();
+    if (mode == CaseMode::Insensitive || m == 0) {
+        return SingleEngine::Kmp;
+    }
+    if (m == 1) {
+        return SingleEngine::Memchr;
+    }
+
+    // Распределение байт: сколько раз встречается самый частый байт шаблона.
+    std::array<size_t, 256> frequency{};
+    size_t top = 0;
+    for (const char c : pattern) {
+        top = std::max(top, ++frequency[static_cast<unsigned char>(c)]);
+    }
+    const bool repetitive = PatternPeriod(pattern) * 2 <= m || top * 4 > m * 3;
+    const bool shortText = expectedText != UNKNOWN_TEXT_LENGTH && expectedText < SHORT_TEXT_LENGTH;
+    return repetitive && !shortText ? SingleEngine::TwoWay : SingleEngine::Horspool;
+}
+
+// Класс SinglePattern — шаблон с выбранным при создании движком. Как и KmpPattern,
+// после создания не меняется, поиск не выделяет память, а методы можно вызывать из
+// нескольких потоков одновременно.
+class SinglePattern {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit SinglePattern(std::string pattern, CaseMode mode = CaseMode::Sensitive,
+                           size_t expectedText = UNKNOWN_TEXT_LENGTH)
+        : SinglePattern(pattern, mode, PlanSingleSearch(pattern, mode, expectedText)) {}
+
+    // Движок задан явно (для сравнения движков между собой). Memchr — только для
+    // шаблонов из одного байта, любой движок кроме Kmp — только с учётом регистра.
+    SinglePattern(std::string pattern, CaseMode mode, SingleEngine engine)
+        : text(std::move(pattern)), caseMode(mode), engine_(engine) {
+        if ((engine_ != SingleEngine::Kmp && mode != CaseMode::Sensitive) ||
+            (engine_ == SingleEngine::Memchr && text.size() != 1)) {
+            throw std::invalid_argument("SinglePattern: engine does not support this pattern");
+        }
+        switch (engine_) {
+            case SingleEngine::Horspool:
+                buildShifts();
+                break;
+            case SingleEngine::TwoWay:
+                buildFactorization();
+                break;
+            case SingleEngine::Kmp:
+                kmp.emplace(text, mode);
+                break;
+            default:
+                break;
+        }
+    }
+
+    [[nodiscard]] const std::string& pattern() const { return text; }
+    [[nodiscard]] size_t size() const { return text.size(); }
+    [[nodiscard]] CaseMode mode() const { return caseMode; }
+    [[nodiscard]] SingleEngine engine() const { return engine_; }
+
+    // Передаёт позицию начала каждого вхождения в callback(pos) по возрастанию.
+    // Если callback возвращает bool, значение false прекращает поиск.
+    template <typename Callback>
+    void search(std::string_view haystack, Callback&& callback) const {
+        const size_t m = text.size();
+        if (m == 0 || haystack.size() < m) {
+            return;
+        }
+        // KmpPattern считает прочитанные байты и вхождения сам.
+        if (engine_ != SingleEngine::Kmp) {
+            LAB_COUNT(BytesScanned, haystack.size());
+        }
+        switch (engine_) {
+            case SingleEngine::Memchr:
+                searchMemchr(haystack, callback);
+                break;
+            case SingleEngine::Kmp:
+                kmp->search(haystack, callback);
+                return;
+            default: {
+                const size_t start = prefilter(haystack, callback);
+                if (start == SIMD_STOPPED) {
+                    return;
+                }
+                if (engine_ == SingleEngine::Horspool) {
+                    searchHorspool(haystack, start, callback);
+                } else {
+                    searchTwoWay(haystack, start, callback);
+                }
+                break;
+            }
+        }
+    }
+
+    // Записывает позиции всех вхождений в matches (старое содержимое удаляется).
+    void search(std::string_view haystack, std::vector<size_t>& matches) const {
+        matches.clear();
+        search(haystack, [&matches](size_t pos) { matches.push_back(pos); });
+    }
+
+    [[nodiscard]] size_t count(std::string_view haystack) const {
+        size_t result = 0;
+        search(haystack, [&result](size_t) { ++result; });
+        return result;
+    }
+
+    // Возвращает позицию первого вхождения или npos.
+    [[nodiscard]] size_t find_first(std::string_view haystack) const {
+        size_t result = npos;
+        search(haystack, [&result](size_t pos) {
+            result = pos;
+            return false;
+        });
+        return result;
+    }
+
+private:
+    std::string text;
+    CaseMode caseMode = CaseMode::Sensitive;
+    SingleEngine engine_ = SingleEngine::Kmp;
+    // Horspool: сдвиг окна по его последнему байту.
+    std::array<size_t, 256> shift{};
+    // TwoWay: критическая точка (последний индекс левой части, может быть -1),
+    // период и признак периодичного шаблона (левая часть повторяется через период).
+    ptrdiff_t critical = -1;
+    size_t period = 1;
+    bool periodic = false;
+    std::optional<KmpPattern> kmp;
+
+    template <typename Callback>
+    static bool emit(Callback& callback, size_t pos) {
+        LAB_COUNT(Matches, 1);
+        if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t>, bool>) {
+            return callback(pos);
+        } else {
+            callback(pos);
+            return true;
+        }
+    }
+
+    const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>(text.data()); }
+
+    // На длинных текстах Horspool и TwoWay, как и KmpPattern, сначала отбирают позиции
+    // SIMD-префильтром по крайним байтам шаблона (simd.hpp) и продолжают с того места,
+    // где он сдался. Возвращает это место либо SIMD_STOPPED.
+    template <typename Callback>
+    size_t prefilter(std::string_view haystack, Callback& callback) const {
+        const size_t m = text.size();
+        if (haystack.size() - m < SHORT_TEXT_LENGTH) {
+            return 0;
+        }
+        return EdgeScan(haystack.data(), haystack.size(), m, text.front(), text.back(), [&](size_t pos) {
+            if (m > 2 && std::memcmp(haystack.data() + pos + 1, text.data() + 1, m - 2) != 0) {
+                return true;
+            }
+            return emit(callback, pos);
+        });
+    }
+
+    template <typename Callback>
+    void searchMemchr(std::string_view haystack, Callback& callback) const {
+        const char* s = haystack.data();
+        const char* end = s + haystack.size();
+        for (const char* p = s; p < end; ++p) {
+            p = static_cast<const char*>(std::memchr(p, text[0], static_cast<size_t>(end - p)));
+            if (p == nullptr || !emit(callback, static_cast<size_t>(p - s))) {
+                return;
+            }
+        }
+    }
+
+    void buildShifts() {
+        const size_t m = text.size();
+        shift.fill(m);
+        for (size_t i = 0; i + 1 < m; ++i) {
+            shift[bytes()[i]] = m - 1 - i;
+        }
+    }
+
+    template <typename Callback>
+    void searchHorspool(std::string_view haystack, size_t start, Callback& callback) const {
+        const auto* s = reinterpret_cast<const unsigned char*>(haystack.data());
+        const size_t m = text.size();
+        const size_t n = haystack.size();
+        const unsigned char last = bytes()[m - 1];
+        for (size_t j = start; j + m <= n; j += shift[s[j + m - 1]]) {
+            if (s[j + m - 1] == last && std::memcmp(s + j, bytes(), m - 1) == 0 && !emit(callback, j)) {
+                return;
+            }
+        }
+    }
+
+    // Наибольший суффикс шаблона в прямом (reverse = false) или обратном порядке байт:
+    // возвращает индекс перед его началом и период этого суффикса.
+    std::pair<ptrdiff_t, size_t> maximalSuffix(bool reverse) const {
+        const unsigned char* x = bytes();
+        const auto m = static_cast<ptrdiff_t>(text.size());
+        ptrdiff_t ms = -1;
+        ptrdiff_t j = 0;
+        ptrdiff_t k = 1;
+        ptrdiff_t p = 1;
+        while (j + k < m) {
+            const unsigned char a = x[j + k];
+            const unsigned char b = x[ms + k];
+            if (reverse ? a > b : a < b) {
+                j += k;
+                k = 1;
+                p = j - ms;
+            } else if (a == b) {
+                if (k != p) {
+                    ++k;
+                } else {
+                    j += p;
+                    k = 1;
+                }
+            } else {
+                ms = j;
+                j = ms + 1;
+                k = p = 1;
+            }
+        }
+        return {ms, static_cast<size_t>(p)};
+    }
+
+    void buildFactorization() {
+        const auto [direct, directPeriod] = maximalSuffix(false);
+        const auto [inverse, inversePeriod] = maximalSuffix(true);
+        critical = direct > inverse ? direct : inverse;
+        period = direct > inverse ? directPeriod : inversePeriod;
+
+        const size_t m = text.size();
+        const auto left = static_cast<size_t>(critical + 1);
+        periodic = period + left <= m && std::memcmp(bytes(), bytes() + period, left) == 0;
+        if (!periodic) {
+            period = std::max(left, m - left) + 1;
+        }
+    }
+
+    template <typename Callback>
+    void searchTwoWay(std::string_view haystack, size_t start, Callback& callback) const {
+        const auto* y = reinterpret_cast<const unsigned char*>(haystack.data());
+        const unsigned char* x = bytes();
+        const auto m = static_cast<ptrdiff_t>(text.size());
+        const auto n = static_cast<ptrdiff_t>(haystack.size());
+        const auto per = static_cast<ptrdiff_t>(period);
+        // memory — сколько байт левой части уже известно совпавшими после сдвига на
+        // период (только для периодичного шаблона).
+        ptrdiff_t memory = -1;
+
+        for (auto j = static_cast<ptrdiff_t>(start); j <= n - m;) {
+            ptrdiff_t i = std::max(critical, memory) + 1;
+            while (i < m && x[i] == y[i + j]) {
+                ++i;
+            }
+            if (i < m) {
+                j += i - critical;
+                memory = -1;
+                continue;
+            }
+            i = critical;
+            while (i > memory && x[i] == y[i + j]) {
+                --i;
+            }
+            if (i <= memory && !emit(callback, static_cast<size_t>(j))) {
+                return;
+            }
+            j += per;
+            memory = periodic ? m - per - 1 : -1;
+        }
+    }
+};
+
+#endif // PLANNER_HPP
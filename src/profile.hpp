@@ -0,0 +1,240 @@
+// ============================================================================
+// Данный заголовочный файл содержит счётчики горячего пути, включаемые при сборке
+// (LAB_PROFILE), и таймеры фаз с отчётом в JSON.
+// ============================================================================
+
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Счётчики:
+// Сборка с -DLAB_PROFILE=1 включает счётчики в циклах поиска: прочитанные байты,
+// переходы автомата, шаги по суффиксным ссылкам (разреженные узлы Ахо–Корасик и
+// префикс-функция KMP), просмотренные узлы конечных ссылок up, найденные вхождения и
+// выделения памяти. Без этого флага LAB_COUNT раскрывается в ((void)0) и код поиска
+// не меняется ни на одну инструкцию.
+//
+// Каждый поток копит счётчики в своём thread_local блоке без атомарных операций и
+// при завершении потока прибавляет их к общим итогам под мьютексом. ProfileTotals()
+// складывает итоги с блоком текущего потока, поэтому его стоит вызывать, когда
+// рабочие потоки уже завершены (ParallelChunks дожидается их сам).
+//
+// Фазы:
+// ProfileReport хранит длительности фаз (загрузка, разбор, построение, поиск, запись),
+// ProfilePhase замеряет фазу от создания до next() или разрушения. Таймеры работают
+// в любой сборке — это несколько вызовов часов на фазу, — а writeJson записывает
+// отчёт вместе со счётчиками (или null, если они не собраны).
+//
+// Выделения памяти:
+// LAB_DEFINE_COUNTING_NEW заменяет глобальные operator new/delete версиями, которые
+// считают выделения в ProfileAllocations(). Макрос раскрывается в одной единице
+// трансляции программы: в main.cpp профилирующей сборки и в бенчмарке.
+
+// =============================================================
+// | LAB_COUNT(Counter, n) | ProfilePhase(report, name).next() |
+// | ProfileReport.writeJson(path) | LAB_DEFINE_COUNTING_NEW   |
+// =============================================================
+
+#ifndef LAB_PROFILE
+#define LAB_PROFILE 0
+#endif
+
+inline constexpr uint32_t PROFILE_REPORT_VERSION = 1;
+
+enum class Counter { BytesScanned, StateTransitions, FailureSteps, OutputWalks, Matches, Allocations };
+inline constexpr size_t COUNTER_KINDS = 6;
+
+[[nodiscard]] inline const char* CounterName(Counter counter) {
+    static const char* const names[COUNTER_KINDS] = {"bytes_scanned", "state_transitions", "failure_steps",
+                                                     "output_walks", "matches", "allocations"};
+    return names[static_cast<size_t>(counter)];
+}
+
+using CounterValues = std::array<uint64_t, COUNTER_KINDS>;
+
+// Выделения считаются отдельным атомарным счётчиком: operator new вызывается и там,
+// где thread_local блок потока ещё не создан или уже разрушен.
+inline std::atomic<uint64_t>& ProfileAllocations() {
+    static std::atomic<uint64_t> allocations{0};
+    return allocations;
+}
+
+// GCC принимает пару malloc/free внутри заменённых операторов за несоответствие new/delete.
+#if defined(__GNUC__) && !defined(__clang__)
+#define LAB_IGNORE_MISMATCHED_NEW_DELETE _Pragma("GCC diagnostic ignored \"-Wmismatched-new-delete\"")
+#else
+#define LAB_IGNORE_MISMATCHED_NEW_DELETE
+#endif
+
+#define LAB_DEFINE_COUNTING_NEW                                                  \
+    LAB_IGNORE_MISMATCHED_NEW_DELETE                                             \
+    void* operator new(std::size_t size) {                                       \
+        ProfileAllocations().fetch_add(1, std::memory_order_relaxed);            \
+        if (void* p = std::malloc(size == 0 ? 1 : size)) {                       \
+            return p;                                                            \
+        }                                                                        \
+        throw std::bad_alloc();                                                  \
+    }                                                                            \
+    void operator delete(void* p) noexcept { std::free(p); }                     \
+    void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#if LAB_PROFILE
+
+// Общие итоги завершившихся потоков.
+inline std::mutex& ProfileTotalsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline CounterValues& ProfileFinishedTotals() {
+    static CounterValues totals{};
+    return totals;
+}
+
+class ProfileCounters {
+public:
+    ProfileCounters() = default;
+    ProfileCounters(const ProfileCounters&) = delete;
+    ProfileCounters& operator=(const ProfileCounters&) = delete;
+
+    ~ProfileCounters() {
+        const std::lock_guard<std::mutex> lock(ProfileTotalsMutex());
+        CounterValues& totals = ProfileFinishedTotals();
+        for (size_t k = 0; k < COUNTER_KINDS; ++k) {
+            totals[k] += values[k];
+        }
+    }
+
+    [[nodiscard]] static ProfileCounters& local() {
+        thread_local ProfileCounters counters;
+        return counters;
+    }
+
+    void add(Counter counter, uint64_t n) { values[static_cast<size_t>(counter)] += n; }
+
+    [[nodiscard]] const CounterValues& current() const { return values; }
+
+private:
+    CounterValues values{};
+};
+
+#define LAB_COUNT(counter, n) (ProfileCounters::local().add(Counter::counter, static_cast<uint64_t>(n)))
+
+[[nodiscard]] inline CounterValues ProfileTotals() {
+    CounterValues result;
+    {
+        const std::lock_guard<std::mutex> lock(ProfileTotalsMutex());
+        result = ProfileFinishedTotals();
+    }
+    const CounterValues& mine = ProfileCounters::local().current();
+    for (size_t k = 0; k < COUNTER_KINDS; ++k) {
+        result[k] += mine[k];
+    }
+    result[static_cast<size_t>(Counter::Allocations)] += ProfileAllocations().load(std::memory_order_relaxed);
+    return result;
+}
+
+#else
+
+#define LAB_COUNT(counter, n) ((void)0)
+
+#endif // LAB_PROFILE
+
+// Класс ProfileReport — длительности фаз одного запуска. Фазы записываются из
+// основного потока; одинаковые имена не склеиваются, порядок — порядок завершения.
+class ProfileReport {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ProfileReport() : started(Clock::now()) {}
+
+    void record(std::string name, double ms) { phases.push_back(Phase{std::move(name), ms}); }
+
+    // Записывает отчёт: версия, включены ли счётчики, фазы в миллисекундах, общее
+    // время с создания отчёта и счётчики (null, если сборка без LAB_PROFILE).
+    void writeJson(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Failed to open profile report: " + path);
+        }
+        const double total = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        file << "{\n  \"version\": " << PROFILE_REPORT_VERSION << ",\n"
+             << "  \"counters_enabled\": " << (LAB_PROFILE ? "true" : "false") << ",\n"
+             << "  \"total_ms\": " << total << ",\n  \"phases\": [";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << phases[i].name << "\", \"ms\": " << phases[i].ms
+                 << "}";
+        }
+        file << (phases.empty() ? "],\n" : "\n  ],\n") << "  \"counters\": ";
+#if LAB_PROFILE
+        const CounterValues totals = ProfileTotals();
+        file << "{";
+        for (size_t k = 0; k < COUNTER_KINDS; ++k) {
+            file << (k == 0 ? "" : ", ") << "\"" << CounterName(static_cast<Counter>(k)) << "\": " << totals[k];
+        }
+        file << "}\n}\n";
+#else
+        file << "null\n}\n";
+#endif
+        if (!file) {
+            throw std::runtime_error("Failed to write profile report: " + path);
+        }
+    }
+
+private:
+    struct Phase {
+        std::string name;
+        double ms;
+    };
+
+    Clock::time_point started;
+    std::vector<Phase> phases;
+};
+
+// Класс ProfilePhase замеряет фазу name от создания до next() или разрушения.
+// next(other) закрывает текущую фазу и сразу открывает следующую, так что подряд
+// идущие фазы main.cpp меряются одним объектом без лишних блоков.
+class ProfilePhase {
+public:
+    ProfilePhase(ProfileReport& report, std::string name)
+        : report(&report), name(std::move(name)), start(ProfileReport::Clock::now()) {}
+
+    ProfilePhase(const ProfilePhase&) = delete;
+    ProfilePhase& operator=(const ProfilePhase&) = delete;
+
+    ~ProfilePhase() { finish(); }
+
+    void next(std::string other) {
+        finish();
+        name = std::move(other);
+        start = ProfileReport::Clock::now();
+        running = true;
+    }
+
+    void finish() {
+        if (running) {
+            report->record(name, std::chrono::duration<double, std::milli>(ProfileReport::Clock::now() - start).count());
+            running = false;
+        }
+    }
+
+private:
+    ProfileReport* report;
+    std::string name;
+    ProfileReport::Clock::time_point start;
+    bool running = true;
+};
+
+#endif // PROFILE_HPP
@@ -0,0 +1,382 @@
+// ============================================================================
+// Данный заголовочный файл содержит поиск по запросу: наборы шаблонов для полей
+// строки, объединённые через AND/OR/NOT, проверяются за один проход по строке.
+// ============================================================================
+
+#ifndef QUERY_HPP
+#define QUERY_HPP
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ac.hpp"
+#include "records.hpp"
+
+// Синтаксис запроса:
+//   expr   := term { OR term }
+//   term   := factor { AND factor }
+//   factor := NOT factor | '(' expr ')' | atom
+//   atom   := field ':' pattern               — поле содержит шаблон;
+//           | field ':' '{' pattern, ... '}'  — поле содержит хотя бы один из шаблонов;
+//           | field ':' '[' pattern, ... ']'  — поле содержит все шаблоны (AND атомов)
+//   field  := номер поля (0, 1, 2) | '*' — любое поле
+//   pattern := слово без пробелов и символов (){}[],:&|!" | строка в кавычках "..."
+// Операторы пишутся словами (AND, OR, NOT в любом регистре) или знаками &, |, !.
+// Пример: 0:2720 AND 2:{6,2,8,7}
+//
+// Логика выполнения:
+// 1. Все шаблоны запроса компилируются в один автомат Ахо–Корасик; каждому шаблону
+//    сопоставлен список атомов, в которых он встречается, вместе с их полями.
+// 2. Поля строки просматриваются автоматом по очереди (каждый байт — один раз).
+//    Найденный в поле f шаблон делает истинными свои атомы с полем f или '*'.
+// 3. Атом, не ставший истинным, ложен, как только пройдены все поля, где он мог
+//    совпасть. Выражение вычисляется в трёхзначной логике (истина, ложь, неизвестно)
+//    после каждого изменения атомов; как только значение определено, поиск по
+//    строке прекращается. Поля, которые запрос не затрагивает, не читаются.
+
+// ==============================================================
+// | FieldQuery(spec).matches(record, state)                    |
+// | FieldQuery(spec).matches(fields, count, state)             |
+// ==============================================================
+
+class FieldQuery {
+public:
+    static constexpr uint32_t ANY_FIELD = UINT32_MAX;
+
+    explicit FieldQuery(std::string_view spec, CaseMode mode = CaseMode::Sensitive) {
+        Parser parser{spec, *this};
+        parser.parse();
+        buildHits();
+        automaton.emplace(patterns, mode);
+    }
+
+    [[nodiscard]] size_t atomCount() const { return atomField.size(); }
+    [[nodiscard]] size_t patternCount() const { return patterns.size(); }
+
+    // Проверяет строку из count полей. state — переиспользуемый буфер вызывающего
+    // (по одному на поток), чтобы проверка строки не выделяла память.
+    [[nodiscard]] bool matches(const std::string_view* fields, size_t count, std::vector<uint8_t>& state) const {
+        const size_t atoms = atomField.size();
+        state.assign(atoms + program.size(), IS_UNKNOWN);
+        uint8_t* const value = state.data();
+        uint8_t* const stack = state.data() + atoms;
+
+        uint8_t verdict = evaluate(value, stack);
+        for (size_t f = 0; f < count && verdict == IS_UNKNOWN; ++f) {
+            if (f < FIELD_MASK_BITS && !(fieldMask & (uint64_t{1} << f)) && !anyField) {
+                continue;
+            }
+            AcCursor cursor;
+            automaton->searchFrom(cursor, fields[f], [&](size_t, uint32_t pattern) {
+                bool changed = false;
+                for (uint32_t k = hitBegin[pattern]; k < hitBegin[pattern + 1]; ++k) {
+                    const uint32_t atom = hitAtoms[k];
+                    if (value[atom] == IS_UNKNOWN && (atomField[atom] == f || atomField[atom] == ANY_FIELD)) {
+                        value[atom] = IS_TRUE;
+                        changed = true;
+                    }
+                }
+                if (changed) {
+                    verdict = evaluate(value, stack);
+                }
+                return verdict == IS_UNKNOWN;
+            });
+            if (verdict != IS_UNKNOWN) {
+                break;
+            }
+            // Поле f пройдено: его атомы, которые не совпали, ложны.
+            for (size_t a = 0; a < atoms; ++a) {
+                if (value[a] == IS_UNKNOWN && atomField[a] == f) {
+                    value[a] = IS_FALSE;
+                }
+            }
+            verdict = evaluate(value, stack);
+        }
+        if (verdict == IS_UNKNOWN) {
+            // Все поля пройдены: оставшиеся атомы ('*' и полей за пределами строки) ложны.
+            for (size_t a = 0; a < atoms; ++a) {
+                if (value[a] == IS_UNKNOWN) {
+                    value[a] = IS_FALSE;
+                }
+            }
+            verdict = evaluate(value, stack);
+        }
+        return verdict == IS_TRUE;
+    }
+
+    [[nodiscard]] bool matches(const RecordView& record, std::vector<uint8_t>& state) const {
+        const std::string_view fields[RecordView::size()] = {record[0], record[1], record[2]};
+        return matches(fields, RecordView::size(), state);
+    }
+
+private:
+    static constexpr uint8_t IS_FALSE = 0;
+    static constexpr uint8_t IS_TRUE = 1;
+    static constexpr uint8_t IS_UNKNOWN = 2;
+    static constexpr size_t FIELD_MASK_BITS = 64;
+
+    // Выражение хранится в обратной польской записи.
+    enum class Op : uint8_t { Atom, And, Or, Not };
+    struct Instr {
+        Op op;
+        uint32_t atom;
+    };
+
+    std::vector<Instr> program;
+    std::vector<uint32_t> atomField;
+    std::vector<std::string> patterns;
+    // Пары (шаблон, атом) при разборе; после buildHits — CSR: атомы шаблона p лежат
+    // в hitAtoms[hitBegin[p] .. hitBegin[p + 1]).
+    std::vector<std::pair<uint32_t, uint32_t>> hits;
+    std::vector<uint32_t> hitBegin;
+    std::vector<uint32_t> hitAtoms;
+    // Поля, на которые ссылаются атомы (номера < 64), и есть ли атомы с '*'.
+    uint64_t fieldMask = 0;
+    bool anyField = false;
+    std::optional<AhoCorasick> automaton;
+
+    [[nodiscard]] uint8_t evaluate(const uint8_t* value, uint8_t* stack) const {
+        size_t top = 0;
+        for (const Instr& in : program) {
+            switch (in.op) {
+                case Op::Atom:
+                    stack[top++] = value[in.atom];
+                    break;
+                case Op::Not:
+                    stack[top - 1] = stack[top - 1] == IS_UNKNOWN ? IS_UNKNOWN : static_cast<uint8_t>(stack[top - 1] ^ 1);
+                    break;
+                case Op::And: {
+                    const uint8_t b = stack[--top];
+                    const uint8_t a = stack[top - 1];
+                    stack[top - 1] = (a == IS_FALSE || b == IS_FALSE) ? IS_FALSE : (a == IS_TRUE && b == IS_TRUE ? IS_TRUE : IS_UNKNOWN);
+                    break;
+                }
+                case Op::Or: {
+                    const uint8_t b = stack[--top];
+                    const uint8_t a = stack[top - 1];
+                    stack[top - 1] = (a == IS_TRUE || b == IS_TRUE) ? IS_TRUE : (a == IS_FALSE && b == IS_FALSE ? IS_FALSE : IS_UNKNOWN);
+                    break;
+                }
+            }
+        }
+        return stack[0];
+    }
+
+    uint32_t addAtom(uint32_t field) {
+        atomField.push_back(field);
+        if (field == ANY_FIELD) {
+            anyField = true;
+        } else if (field < FIELD_MASK_BITS) {
+            fieldMask |= uint64_t{1} << field;
+        }
+        return static_cast<uint32_t>(atomField.size() - 1);
+    }
+
+    void addHit(uint32_t atom, const std::string& pattern, std::unordered_map<std::string, uint32_t>& index) {
+        const auto [it, inserted] = index.emplace(pattern, static_cast<uint32_t>(patterns.size()));
+        if (inserted) {
+            patterns.push_back(pattern);
+        }
+        hits.emplace_back(it->second, atom);
+    }
+
+    void buildHits() {
+        hitBegin.assign(patterns.size() + 1, 0);
+        for (const auto& [pattern, atom] : hits) {
+            ++hitBegin[pattern + 1];
+        }
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            hitBegin[p + 1] += hitBegin[p];
+        }
+        hitAtoms.resize(hits.size());
+        std::vector<uint32_t> fill(hitBegin.begin(), hitBegin.end() - 1);
+        for (const auto& [pattern, atom] : hits) {
+            hitAtoms[fill[pattern]++] = atom;
+        }
+        hits.clear();
+        hits.shrink_to_fit();
+    }
+
+    // Рекурсивный спуск по грамматике из описания; ошибки — std::invalid_argument
+    // с позицией в строке запроса.
+    struct Parser {
+        std::string_view spec;
+        FieldQuery& query;
+        size_t pos = 0;
+        std::unordered_map<std::string, uint32_t> index{};
+
+        void parse() {
+            expr();
+            skipSpace();
+            if (pos != spec.size()) {
+                fail("unexpected input");
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& what) const {
+            throw std::invalid_argument("Query: " + what + " at position " + std::to_string(pos));
+        }
+
+        void skipSpace() {
+            while (pos < spec.size() && (spec[pos] == ' ' || spec[pos] == '\t')) {
+                ++pos;
+            }
+        }
+
+        static bool isSpecial(char c) {
+            return c == ' ' || c == '\t' || c == '(' || c == ')' || c == '{' || c == '}' || c == '[' ||
+                   c == ']' || c == ',' || c == ':' || c == '&' || c == '|' || c == '!' || c == '"';
+        }
+
+        // Оператор: знак или ключевое слово, за которым идёт не буква слова.
+        bool accept(char sign, std::string_view word) {
+            skipSpace();
+            if (pos < spec.size() && spec[pos] == sign) {
+                ++pos;
+                return true;
+            }
+            if (spec.size() - pos < word.size()) {
+                return false;
+            }
+            for (size_t k = 0; k < word.size(); ++k) {
+                const char c = spec[pos + k];
+                if ((c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c) != word[k]) {
+                    return false;
+                }
+            }
+            const size_t after = pos + word.size();
+            if (after < spec.size() && !isSpecial(spec[after])) {
+                return false;
+            }
+            pos = after;
+            return true;
+        }
+
+        void expect(char c) {
+            skipSpace();
+            if (pos >= spec.size() || spec[pos] != c) {
+                fail(std::string("expected '") + c + "'");
+            }
+            ++pos;
+        }
+
+        void emit(Op op, uint32_t atom = 0) { query.program.push_back(Instr{op, atom}); }
+
+        void expr() {
+            term();
+            while (accept('|', "OR")) {
+                term();
+                emit(Op::Or);
+            }
+        }
+
+        void term() {
+            factor();
+            while (accept('&', "AND")) {
+                factor();
+                emit(Op::And);
+            }
+        }
+
+        void factor() {
+            if (accept('!', "NOT")) {
+                factor();
+                emit(Op::Not);
+                return;
+            }
+            skipSpace();
+            if (pos < spec.size() && spec[pos] == '(') {
+                ++pos;
+                expr();
+                expect(')');
+                return;
+            }
+            atom();
+        }
+
+        uint32_t field() {
+            skipSpace();
+            if (pos < spec.size() && spec[pos] == '*') {
+                ++pos;
+                return ANY_FIELD;
+            }
+            if (pos >= spec.size() || spec[pos] < '0' || spec[pos] > '9') {
+                fail("expected field number or '*'");
+            }
+            uint64_t value = 0;
+            while (pos < spec.size() && spec[pos] >= '0' && spec[pos] <= '9') {
+                value = value * 10 + static_cast<uint64_t>(spec[pos++] - '0');
+                if (value >= ANY_FIELD) {
+                    fail("field number is too large");
+                }
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        std::string pattern() {
+            skipSpace();
+            std::string out;
+            if (pos < spec.size() && spec[pos] == '"') {
+                ++pos;
+                while (pos < spec.size() && spec[pos] != '"') {
+                    if (spec[pos] == '\\' && pos + 1 < spec.size()) {
+                        ++pos;
+                    }
+                    out += spec[pos++];
+                }
+                expect('"');
+            } else {
+                while (pos < spec.size() && !isSpecial(spec[pos])) {
+                    out += spec[pos++];
+                }
+            }
+            if (out.empty()) {
+                fail("expected pattern");
+            }
+            return out;
+        }
+
+        void atom() {
+            const uint32_t f = field();
+            expect(':');
+            skipSpace();
+            if (pos < spec.size() && (spec[pos] == '{' || spec[pos] == '[')) {
+                const bool all = spec[pos] == '[';
+                const char close = all ? ']' : '}';
+                ++pos;
+                // {a, b}: один атом со всеми шаблонами; [a, b]: по атому на шаблон, через AND.
+                uint32_t shared = all ? 0 : query.addAtom(f);
+                if (!all) {
+                    emit(Op::Atom, shared);
+                }
+                for (size_t items = 0;; ++items) {
+                    const std::string p = pattern();
+                    if (all) {
+                        shared = query.addAtom(f);
+                        emit(Op::Atom, shared);
+                        if (items > 0) {
+                            emit(Op::And);
+                        }
+                    }
+                    query.addHit(shared, p, index);
+                    skipSpace();
+                    if (pos >= spec.size() || spec[pos] != ',') {
+                        break;
+                    }
+                    ++pos;
+                }
+                expect(close);
+                return;
+            }
+            const uint32_t a = query.addAtom(f);
+            emit(Op::Atom, a);
+            query.addHit(a, pattern(), index);
+        }
+    };
+};
+
+#endif // QUERY_HPP
@@ -0,0 +1,162 @@
+// ============================================================================
+// Данный заголовочный файл содержит колоночное хранилище записей (три группы
+// слов на строку), в котором все байты полей лежат в одной непрерывной арене.
+// ============================================================================
+
+#ifndef RECORDS_HPP
+#define RECORDS_HPP
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "file.hpp"
+
+// Устройство хранилища:
+// 1. arena — одна строка, в которую подряд дописываются поля всех записей:
+//    группа 0, группа 1, группа 2 первой записи, затем второй и т. д.
+// 2. Для каждой группы хранятся две колонки (struct of arrays): смещение поля
+//    в арене (uint64_t) и его длина (uint32_t).
+// 3. Запись — лёгкий объект RecordView (хранилище + номер), поле которого
+//    возвращается как string_view на арену.
+//
+// Строка файла стоит одну-две дописки в арену вместо ~10 выделений памяти в
+// LinesWithWords, а циклы поиска идут по непрерывной памяти.
+
+// ==================================================================================
+// | RecordStore | RecordView | LinesWithWordsColumnar | LoadLinesWithWordsColumnar |
+// ==================================================================================
+
+class RecordStore;
+
+class RecordView {
+public:
+    RecordView(const RecordStore* owner, size_t record) : store(owner), index(record) {}
+
+    [[nodiscard]] std::string_view operator[](size_t group) const;
+    [[nodiscard]] static constexpr size_t size() { return 3; }
+    [[nodiscard]] size_t line() const { return index; }
+
+private:
+    const RecordStore* store;
+    size_t index;
+};
+
+class RecordStore {
+public:
+    static constexpr size_t GROUPS = 3;
+
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = RecordView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = RecordView;
+
+        iterator(const RecordStore* owner, size_t record) : store(owner), index(record) {}
+
+        RecordView operator*() const { return RecordView(store, index); }
+        RecordView operator[](difference_type n) const { return RecordView(store, index + n); }
+        iterator& operator++() { ++index; return *this; }
+        iterator operator++(int) { iterator old = *this; ++index; return old; }
+        iterator& operator--() { --index; return *this; }
+        iterator& operator+=(difference_type n) { index += n; return *this; }
+        iterator operator+(difference_type n) const { return iterator(store, index + n); }
+        difference_type operator-(const iterator& other) const {
+            return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+        }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+        bool operator<(const iterator& other) const { return index < other.index; }
+
+    private:
+        const RecordStore* store;
+        size_t index;
+    };
+
+    void reserve(size_t records, size_t bytes) {
+        arena.reserve(bytes);
+        for (size_t g = 0; g < GROUPS; ++g) {
+            offsets[g].reserve(records);
+            lengths[g].reserve(records);
+        }
+    }
+
+    // Начинает поле группы group у новой записи; байты поля дописываются через
+    // append, а endField фиксирует его длину. Группы добавляются по порядку 0, 1, 2.
+    void beginField(size_t group) {
+        offsets[group].push_back(arena.size());
+    }
+
+    void append(std::string_view bytes) {
+        arena.append(bytes.data(), bytes.size());
+    }
+
+    void endField(size_t group) {
+        const size_t length = arena.size() - offsets[group].back();
+        if (length > UINT32_MAX) {
+            throw std::length_error("RecordStore: field is too long");
+        }
+        lengths[group].push_back(static_cast<uint32_t>(length));
+    }
+
+    [[nodiscard]] std::string_view field(size_t record, size_t group) const {
+        return {arena.data() + offsets[group][record], lengths[group][record]};
+    }
+
+    [[nodiscard]] RecordView operator[](size_t record) const { return RecordView(this, record); }
+    [[nodiscard]] size_t size() const { return lengths[GROUPS - 1].size(); }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] size_t bytes() const { return arena.size(); }
+
+    [[nodiscard]] iterator begin() const { return iterator(this, 0); }
+    [[nodiscard]] iterator end() const { return iterator(this, size()); }
+
+private:
+    std::string arena;
+    std::array<std::vector<uint64_t>, GROUPS> offsets;
+    std::array<std::vector<uint32_t>, GROUPS> lengths;
+};
+
+inline std::string_view RecordView::operator[](size_t group) const {
+    return store->field(index, group);
+}
+
+// LinesWithWordsColumnar разбирает уже загруженное содержимое файла так же, как
+// LinesWithWords (строки короче шести слов пропускаются), но складывает группы в
+// RecordStore. Слова группы дописываются в арену через один пробел, временных строк
+// не создаётся.
+[[nodiscard]] inline RecordStore LinesWithWordsColumnar(std::string_view content) {
+    RecordStore store;
+    store.reserve(content.size() / 40, content.size());
+
+    ForEachGroupedLine(content, [&](const GroupWords& words, size_t count) {
+        for (size_t g = 0; g < RecordStore::GROUPS; ++g) {
+            const auto [first, last] = GroupRange(g, count);
+            store.beginField(g);
+            for (size_t k = first; k <= last; ++k) {
+                if (k != first) {
+                    store.append(" ");
+                }
+                store.append(words[k]);
+            }
+            store.endField(g);
+        }
+    });
+
+    return store;
+}
+
+// LoadLinesWithWordsColumnar отображает файл filename в память и разбирает его.
+// Имя отличается от LinesWithWordsColumnar, чтобы строка с содержимым не открылась
+// как путь к файлу.
+[[nodiscard]] inline RecordStore LoadLinesWithWordsColumnar(const std::string& filename) {
+    const MappedFile file(filename);
+    return LinesWithWordsColumnar(file.view());
+}
+
+#endif // RECORDS_HPP
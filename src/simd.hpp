@@ -0,0 +1,143 @@
+// ============================================================================
+// Данный заголовочный файл содержит SIMD-примитивы (SSE2/AVX2) для быстрого
+// отбора позиций-кандидатов перед точной проверкой совпадения.
+// ============================================================================
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LAB_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define LAB_SIMD_X86 0
+#endif
+
+// Логика префильтра:
+// 1. Первый и последний байты шаблона размножаются по всем полосам SIMD-регистра.
+// 2. Из текста загружаются два блока: с позиции i и с позиции i + m - 1.
+// 3. Побитовое И результатов сравнения даёт маску позиций, где совпали оба крайних байта.
+// 4. Только эти позиции передаются на точную проверку (verify).
+//
+// Если кандидатов оказывается слишком много (например, текст из одного повторяющегося
+// символа), префильтр возвращает позицию, с которой вызывающий код продолжает обычным
+// алгоритмом, чтобы не потерять гарантию линейного времени.
+
+// Набор инструкций выбирается один раз во время выполнения: SSE2 есть на любом x86-64,
+// AVX2 — только на процессорах, где его поддержку подтверждает cpuid.
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+[[nodiscard]] inline SimdLevel DetectSimd() {
+#if LAB_SIMD_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// SSSE3 (pshufb) нужен для поиска по таблицам полубайтов (smallset.hpp); на x86-64
+// он есть почти везде, но не гарантирован, поэтому проверяется отдельно.
+[[nodiscard]] inline bool HasSsse3() {
+#if LAB_SIMD_X86
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// Значение, которое префильтры возвращают, если verify потребовал остановить поиск.
+inline constexpr size_t SIMD_STOPPED = static_cast<size_t>(-1);
+
+// Допустимое число кандидатов на позиции pos, после которого префильтр сдаётся.
+[[nodiscard]] inline bool TooManyCandidates(size_t candidates, size_t pos) {
+    return candidates > 64 + (pos >> 3);
+}
+
+#if LAB_SIMD_X86
+
+// EdgeScanSSE2 / EdgeScanAVX2 проверяют позиции [0, n - m] блоками по 16/32 байт.
+// verify(pos) вызывается для каждого кандидата и возвращает false для остановки.
+// Возвращают позицию, до которой все начала вхождений уже обработаны
+// (с неё вызывающий код продолжает скалярно), либо SIMD_STOPPED.
+template <typename Verify>
+size_t EdgeScanSSE2(const char* s, size_t n, size_t m, char first, char last, Verify&& verify) {
+    const __m128i vf = _mm_set1_epi8(first);
+    const __m128i vl = _mm_set1_epi8(last);
+    size_t candidates = 0;
+    size_t i = 0;
+
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, vf), _mm_cmpeq_epi8(b, vl))));
+
+        while (mask != 0) {
+            const size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (TooManyCandidates(++candidates, pos)) {
+                return pos;
+            }
+            if (!verify(pos)) {
+                return SIMD_STOPPED;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+template <typename Verify>
+__attribute__((target("avx2")))
+size_t EdgeScanAVX2(const char* s, size_t n, size_t m, char first, char last, Verify&& verify) {
+    const __m256i vf = _mm256_set1_epi8(first);
+    const __m256i vl = _mm256_set1_epi8(last);
+    size_t candidates = 0;
+    size_t i = 0;
+
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + m - 1));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, vf), _mm256_cmpeq_epi8(b, vl))));
+
+        while (mask != 0) {
+            const size_t pos = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (TooManyCandidates(++candidates, pos)) {
+                return pos;
+            }
+            if (!verify(pos)) {
+                return SIMD_STOPPED;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+#endif // LAB_SIMD_X86
+
+// EdgeScan выбирает реализацию по DetectSimd(). Без SIMD возвращает 0: весь текст
+// остаётся скалярному алгоритму.
+template <typename Verify>
+size_t EdgeScan(const char* s, size_t n, size_t m, char first, char last, Verify&& verify) {
+#if LAB_SIMD_X86
+    switch (DetectSimd()) {
+        case SimdLevel::AVX2:
+            return EdgeScanAVX2(s, n, m, first, last, verify);
+        case SimdLevel::SSE2:
+            return EdgeScanSSE2(s, n, m, first, last, verify);
+        default:
+            break;
+    }
+#else
+    (void)s; (void)n; (void)m; (void)first; (void)last; (void)verify;
+#endif
+    return 0;
+}
+
+#endif // SIMD_HPP
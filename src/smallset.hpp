@@ -0,0 +1,510 @@
+// ============================================================================
+// Данный заголовочный файл содержит быстрые движки для небольших наборов коротких
+// шаблонов (байтовое множество и Teddy на SSSE3/AVX2) и выбор движка по набору.
+// ============================================================================
+
+#ifndef SMALLSET_HPP
+#define SMALLSET_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "ac.hpp"
+#include "profile.hpp"
+#include "simd.hpp"
+
+// Зачем отдельные движки:
+// Автомат Ахо–Корасик читает текст по байту и на каждом байте делает зависимое
+// чтение таблицы переходов. Для набора из нескольких коротких шаблонов это дорого:
+// почти все байты текста не начинают ни одного вхождения, и их можно отбросить
+// блоком по 16/32 байта.
+//
+// ByteSetMatcher — все шаблоны длиной в один байт. Вхождение — это сам байт, поэтому
+// автомат не нужен: таблица на 256 байт даёт список шаблонов, а containsAll ведёт
+// битовую карту ещё не найденных байт и заканчивает, как только она опустела.
+//
+// TeddyMatcher — до TEDDY_MAX_PATTERNS шаблонов длиной до TEDDY_MAX_LENGTH байт.
+// Каждому шаблону отведён свой бит (корзина). Для первых F = min(3, длина кратчайшего
+// шаблона) байт строятся по две таблицы на 16 элементов: lo[k][x] — корзины, у которых
+// k-й байт имеет младший полубайт x, hi[k][x] — то же для старшего полубайта.
+// 1. Из текста загружаются F блоков: с позиций i, i + 1, ..., i + F - 1.
+// 2. pshufb по младшим и старшим полубайтам блока k даёт для каждой позиции корзины,
+//    совместимые с k-м байтом; И по всем k и обоим полубайтам — корзины-кандидаты.
+// 3. Ненулевые байты результата — позиции, где может начинаться вхождение; каждая
+//    корзина-кандидат проверяется memcmp.
+// Вхождения выдаются в том же порядке, что и у AhoCorasick::search: по возрастанию
+// конца, при равном конце — от длинных к коротким, при равной длине — по индексу.
+//
+// PatternMatcher выбирает движок по набору шаблонов: байтовое множество, Teddy или
+// автомат для всего остального (больших наборов, длинных или пустых шаблонов и поиска
+// без учёта регистра). Результаты совпадают с AhoSearch при любом выборе.
+
+// Сложность:
+// ByteSetMatcher: O(n + k). TeddyMatcher: O(n + c * l), c — число позиций-кандидатов,
+// l ≤ TEDDY_MAX_LENGTH; в худшем случае (каждая позиция — кандидат во всех корзинах)
+// это O(n * TEDDY_MAX_PATTERNS * TEDDY_MAX_LENGTH), то есть по-прежнему линейно.
+
+// =============================================================================
+// | PatternMatcher(vector<string> patterns).containsAll(text, count)          |
+// | PatternMatcher(vector<string> patterns).search(text, callback)            |
+// | PatternSearch (string text, vector<string> patterns, size_t count)        |
+// =============================================================================
+
+inline constexpr size_t TEDDY_MAX_PATTERNS = 8;
+inline constexpr size_t TEDDY_MAX_LENGTH = 16;
+inline constexpr size_t TEDDY_MAX_FINGERPRINT = 3;
+
+// Передаёт вхождение в callback; false — поиск нужно прекратить (как в AhoCorasick).
+template <typename Callback>
+bool EmitSetMatch(Callback& callback, size_t end, uint32_t pattern) {
+    LAB_COUNT(Matches, 1);
+    if constexpr (std::is_same_v<std::invoke_result_t<Callback&, size_t, uint32_t>, bool>) {
+        return callback(end, pattern);
+    } else {
+        callback(end, pattern);
+        return true;
+    }
+}
+
+// Класс ByteSetMatcher — поиск набора однобайтовых шаблонов.
+class ByteSetMatcher {
+public:
+    explicit ByteSetMatcher(const std::vector<std::string>& patterns) : patternCount(patterns.size()) {
+        patternBytes.reserve(patterns.size());
+        for (const auto& p : patterns) {
+            if (p.size() != 1) {
+                throw std::invalid_argument("ByteSetMatcher: all patterns must be single bytes");
+            }
+            patternBytes.push_back(static_cast<unsigned char>(p[0]));
+            ++byteBegin[static_cast<unsigned char>(p[0]) + 1];
+        }
+        for (size_t c = 0; c < 256; ++c) {
+            byteBegin[c + 1] += byteBegin[c];
+        }
+        // Шаблоны одного байта идут по возрастанию индекса.
+        bytePatterns.resize(patterns.size());
+        std::array<uint32_t, 256> next{};
+        std::copy(byteBegin.begin(), byteBegin.end() - 1, next.begin());
+        for (size_t i = 0; i < patternBytes.size(); ++i) {
+            bytePatterns[next[patternBytes[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return patternCount; }
+
+    template <typename Callback>
+    bool search(std::string_view text, Callback&& callback) const {
+        const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+        LAB_COUNT(BytesScanned, text.size());
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            for (uint32_t k = byteBegin[s[pos]]; k < byteBegin[s[pos] + 1]; ++k) {
+                if (!EmitSetMatch(callback, pos + 1, bytePatterns[k])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Возвращает true, если в тексте встретились все шаблоны с индексами меньше count.
+    [[nodiscard]] bool containsAll(std::string_view text, size_t count) const {
+        if (count == 0) {
+            return true;
+        }
+        if (count > patternCount) {
+            return false;
+        }
+        // need — битовая карта байт, которые ещё предстоит встретить.
+        std::array<uint64_t, 4> need{};
+        size_t remaining = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t bit = uint64_t{1} << (patternBytes[i] & 63);
+            uint64_t& word = need[patternBytes[i] >> 6];
+            if ((word & bit) == 0) {
+                word |= bit;
+                ++remaining;
+            }
+        }
+
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            const auto c = static_cast<unsigned char>(text[pos]);
+            const uint64_t bit = uint64_t{1} << (c & 63);
+            if ((need[c >> 6] & bit) != 0) {
+                need[c >> 6] &= ~bit;
+                LAB_COUNT(Matches, 1);
+                if (--remaining == 0) {
+                    LAB_COUNT(BytesScanned, pos + 1);
+                    return true;
+                }
+            }
+        }
+        LAB_COUNT(BytesScanned, text.size());
+        return false;
+    }
+
+    [[nodiscard]] bool containsAll(std::string_view text) const {
+        return containsAll(text, patternCount);
+    }
+
+private:
+    size_t patternCount = 0;
+    std::vector<uint8_t> patternBytes;
+    // Шаблоны байта c: bytePatterns[byteBegin[c] .. byteBegin[c + 1]).
+    std::array<uint32_t, 257> byteBegin{};
+    std::vector<uint32_t> bytePatterns;
+};
+
+// Таблицы полубайтов Teddy: для k-го байта отпечатка — корзины по младшему (lo)
+// и старшему (hi) полубайту.
+struct TeddyMasks {
+    alignas(16) uint8_t lo[TEDDY_MAX_FINGERPRINT][16];
+    alignas(16) uint8_t hi[TEDDY_MAX_FINGERPRINT][16];
+};
+
+#if LAB_SIMD_X86
+
+// TeddyScanSSSE3 / TeddyScanAVX2 проверяют позиции текста блоками по 16/32 байт,
+// пока все F загрузок помещаются в текст. verify(pos, buckets) вызывается для каждой
+// позиции с непустым набором корзин и возвращает false для остановки.
+// Возвращают позицию, с которой вызывающий код продолжает скалярно, либо SIMD_STOPPED.
+template <size_t F, typename Verify>
+__attribute__((target("ssse3")))
+size_t TeddyScanSSSE3(const char* s, size_t n, const TeddyMasks& masks, Verify& verify) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i lo[F];
+    __m128i hi[F];
+    for (size_t k = 0; k < F; ++k) {
+        lo[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(masks.lo[k]));
+        hi[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(masks.hi[k]));
+    }
+    size_t i = 0;
+
+    for (; i + F - 1 + 16 <= n; i += 16) {
+        __m128i acc = _mm_set1_epi8(-1);
+        for (size_t k = 0; k < F; ++k) {
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k));
+            const __m128i l = _mm_shuffle_epi8(lo[k], _mm_and_si128(c, nibble));
+            const __m128i h = _mm_shuffle_epi8(hi[k], _mm_and_si128(_mm_srli_epi16(c, 4), nibble));
+            acc = _mm_and_si128(acc, _mm_and_si128(l, h));
+        }
+        uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128()))) & 0xFFFF;
+        if (mask == 0) {
+            continue;
+        }
+        alignas(16) uint8_t buckets[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(buckets), acc);
+        while (mask != 0) {
+            const size_t j = static_cast<size_t>(__builtin_ctz(mask));
+            if (!verify(i + j, buckets[j])) {
+                return SIMD_STOPPED;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+template <size_t F, typename Verify>
+__attribute__((target("avx2")))
+size_t TeddyScanAVX2(const char* s, size_t n, const TeddyMasks& masks, Verify& verify) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i lo[F];
+    __m256i hi[F];
+    for (size_t k = 0; k < F; ++k) {
+        // pshufb работает внутри 128-битных половин, поэтому таблица повторяется в обеих.
+        lo[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(masks.lo[k])));
+        hi[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(masks.hi[k])));
+    }
+    size_t i = 0;
+
+    for (; i + F - 1 + 32 <= n; i += 32) {
+        __m256i acc = _mm256_set1_epi8(-1);
+        for (size_t k = 0; k < F; ++k) {
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + k));
+            const __m256i l = _mm256_shuffle_epi8(lo[k], _mm256_and_si256(c, nibble));
+            const __m256i h = _mm256_shuffle_epi8(hi[k], _mm256_and_si256(_mm256_srli_epi16(c, 4), nibble));
+            acc = _mm256_and_si256(acc, _mm256_and_si256(l, h));
+        }
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(acc, _mm256_setzero_si256())));
+        if (mask == 0) {
+            continue;
+        }
+        alignas(32) uint8_t buckets[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(buckets), acc);
+        while (mask != 0) {
+            const size_t j = static_cast<size_t>(__builtin_ctz(mask));
+            if (!verify(i + j, buckets[j])) {
+                return SIMD_STOPPED;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+
+#endif // LAB_SIMD_X86
+
+// TeddyScan выбирает реализацию: AVX2, затем SSSE3. Без них возвращает 0 — весь
+// текст остаётся скалярному циклу.
+template <size_t F, typename Verify>
+size_t TeddyScan(const char* s, size_t n, const TeddyMasks& masks, Verify& verify) {
+#if LAB_SIMD_X86
+    if (DetectSimd() == SimdLevel::AVX2) {
+        return TeddyScanAVX2<F>(s, n, masks, verify);
+    }
+    if (HasSsse3()) {
+        return TeddyScanSSSE3<F>(s, n, masks, verify);
+    }
+#else
+    (void)s; (void)n; (void)masks; (void)verify;
+#endif
+    return 0;
+}
+
+// Класс TeddyMatcher — поиск до TEDDY_MAX_PATTERNS коротких шаблонов.
+class TeddyMatcher {
+public:
+    explicit TeddyMatcher(const std::vector<std::string>& patterns) : patternCount(patterns.size()) {
+        if (patterns.empty() || patterns.size() > TEDDY_MAX_PATTERNS) {
+            throw std::invalid_argument("TeddyMatcher: unsupported number of patterns");
+        }
+        size_t shortest = TEDDY_MAX_LENGTH;
+        for (size_t b = 0; b < patterns.size(); ++b) {
+            const std::string& p = patterns[b];
+            if (p.empty() || p.size() > TEDDY_MAX_LENGTH) {
+                throw std::invalid_argument("TeddyMatcher: unsupported pattern length");
+            }
+            std::memcpy(bytes[b].data(), p.data(), p.size());
+            lengths[b] = static_cast<uint32_t>(p.size());
+            shortest = std::min(shortest, p.size());
+        }
+        fingerprint = std::min(shortest, TEDDY_MAX_FINGERPRINT);
+
+        std::memset(&masks, 0, sizeof(masks));
+        for (size_t b = 0; b < patterns.size(); ++b) {
+            for (size_t k = 0; k < fingerprint; ++k) {
+                const auto c = static_cast<unsigned char>(patterns[b][k]);
+                masks.lo[k][c & 0x0F] |= static_cast<uint8_t>(1u << b);
+                masks.hi[k][c >> 4] |= static_cast<uint8_t>(1u << b);
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return patternCount; }
+
+    template <typename Callback>
+    bool search(std::string_view text, Callback&& callback) const {
+        const char* s = text.data();
+        const size_t n = text.size();
+        LAB_COUNT(BytesScanned, n);
+        // Найденные, но ещё не выданные вхождения, упорядоченные как в AhoCorasick.
+        // Вхождение можно выдать, когда проверка дошла до его конца: все вхождения,
+        // начинающиеся дальше, оканчиваются позже. Поэтому одновременно ждут не больше
+        // TEDDY_MAX_PATTERNS вхождений на каждую из TEDDY_MAX_LENGTH последних позиций.
+        std::array<AcMatch, TEDDY_MAX_PATTERNS * TEDDY_MAX_LENGTH> pending;
+        size_t pendingCount = 0;
+
+        auto flush = [&](size_t upTo) {
+            size_t k = 0;
+            for (; k < pendingCount && pending[k].end <= upTo; ++k) {
+                if (!EmitSetMatch(callback, pending[k].end, pending[k].pattern)) {
+                    return false;
+                }
+            }
+            std::copy(pending.begin() + static_cast<std::ptrdiff_t>(k),
+                      pending.begin() + static_cast<std::ptrdiff_t>(pendingCount), pending.begin());
+            pendingCount -= k;
+            return true;
+        };
+        auto before = [&](const AcMatch& a, const AcMatch& b) {
+            if (a.end != b.end) {
+                return a.end < b.end;
+            }
+            if (lengths[a.pattern] != lengths[b.pattern]) {
+                return lengths[a.pattern] > lengths[b.pattern];
+            }
+            return a.pattern < b.pattern;
+        };
+        auto verify = [&](size_t pos, uint32_t buckets) {
+            if (!flush(pos)) {
+                return false;
+            }
+            while (buckets != 0) {
+                const uint32_t b = static_cast<uint32_t>(__builtin_ctz(buckets));
+                buckets &= buckets - 1;
+                if (lengths[b] <= n - pos && std::memcmp(s + pos, bytes[b].data(), lengths[b]) == 0) {
+                    const AcMatch match{pos + lengths[b], b};
+                    size_t k = pendingCount++;
+                    for (; k > 0 && before(match, pending[k - 1]); --k) {
+                        pending[k] = pending[k - 1];
+                    }
+                    pending[k] = match;
+                }
+            }
+            return true;
+        };
+
+        size_t pos = 0;
+        switch (fingerprint) {
+            case 1: pos = TeddyScan<1>(s, n, masks, verify); break;
+            case 2: pos = TeddyScan<2>(s, n, masks, verify); break;
+            default: pos = TeddyScan<3>(s, n, masks, verify); break;
+        }
+        if (pos == SIMD_STOPPED) {
+            return false;
+        }
+        for (; pos < n; ++pos) {
+            const uint32_t buckets = candidates(s, n, pos);
+            if (buckets != 0 && !verify(pos, buckets)) {
+                return false;
+            }
+        }
+        return flush(SIZE_MAX);
+    }
+
+    // Возвращает true, если в тексте встретились все шаблоны с индексами меньше count.
+    [[nodiscard]] bool containsAll(std::string_view text, size_t count) const {
+        if (count == 0) {
+            return true;
+        }
+        if (count > patternCount) {
+            return false;
+        }
+        const uint32_t all = (1u << count) - 1;
+        uint32_t found = 0;
+        search(text, [&](size_t, uint32_t index) {
+            found |= (1u << index) & all;
+            return found != all;
+        });
+        return found == all;
+    }
+
+    [[nodiscard]] bool containsAll(std::string_view text) const {
+        return containsAll(text, patternCount);
+    }
+
+private:
+    size_t patternCount = 0;
+    size_t fingerprint = 1;
+    TeddyMasks masks;
+    std::array<std::array<char, TEDDY_MAX_LENGTH>, TEDDY_MAX_PATTERNS> bytes{};
+    std::array<uint32_t, TEDDY_MAX_PATTERNS> lengths{};
+
+    // Корзины-кандидаты для позиции pos — то же, что SIMD-цикл, по одному байту.
+    [[nodiscard]] uint32_t candidates(const char* s, size_t n, size_t pos) const {
+        uint32_t buckets = 0xFF;
+        for (size_t k = 0; k < fingerprint; ++k) {
+            if (pos + k >= n) {
+                return 0;
+            }
+            const auto c = static_cast<unsigned char>(s[pos + k]);
+            buckets &= masks.lo[k][c & 0x0F] & masks.hi[k][c >> 4];
+        }
+        return buckets;
+    }
+};
+
+// Движок, выбранный PatternMatcher; порядок совпадает с порядком типов в variant.
+enum class MatchEngine { ByteSet, Teddy, Automaton };
+
+// Класс PatternMatcher — набор шаблонов с автоматически выбранным движком.
+// Как и AhoCorasick, строится один раз и не изменяется: константные методы можно
+// вызывать одновременно из нескольких потоков.
+class PatternMatcher {
+public:
+    explicit PatternMatcher(const std::vector<std::string>& patterns, CaseMode mode = CaseMode::Sensitive,
+                            size_t memoryBudget = AC_DEFAULT_MEMORY_BUDGET)
+        : matcher(build(patterns, mode, memoryBudget)) {}
+
+    // Готовый автомат (например, загруженный LoadAutomaton) используется как есть.
+    explicit PatternMatcher(AhoCorasick automaton)
+        : matcher(std::in_place_type<AhoCorasick>, std::move(automaton)) {}
+
+    // Какой движок подходит набору patterns.
+    [[nodiscard]] static MatchEngine chooseEngine(const std::vector<std::string>& patterns, CaseMode mode) {
+        if (mode != CaseMode::Sensitive || patterns.empty()) {
+            return MatchEngine::Automaton;
+        }
+        bool singleBytes = true;
+        bool fitsTeddy = patterns.size() <= TEDDY_MAX_PATTERNS;
+        for (const auto& p : patterns) {
+            // Пустой шаблон автомат никогда не сообщает; оставляем этот случай ему.
+            if (p.empty()) {
+                return MatchEngine::Automaton;
+            }
+            singleBytes = singleBytes && p.size() == 1;
+            fitsTeddy = fitsTeddy && p.size() <= TEDDY_MAX_LENGTH;
+        }
+        if (singleBytes) {
+            return MatchEngine::ByteSet;
+        }
+        return fitsTeddy ? MatchEngine::Teddy : MatchEngine::Automaton;
+    }
+
+    [[nodiscard]] MatchEngine engine() const { return static_cast<MatchEngine>(matcher.index()); }
+
+    [[nodiscard]] size_t size() const {
+        return std::visit([](const auto& m) { return m.size(); }, matcher);
+    }
+
+    // Те же соглашения, что у AhoCorasick::search: callback(end, pattern) в порядке
+    // возрастания end, false из callback прекращает поиск.
+    template <typename Callback>
+    bool search(std::string_view text, Callback&& callback) const {
+        return std::visit([&](const auto& m) { return m.search(text, callback); }, matcher);
+    }
+
+    [[nodiscard]] bool containsAll(std::string_view text, size_t count) const {
+        return std::visit([&](const auto& m) { return m.containsAll(text, count); }, matcher);
+    }
+
+    [[nodiscard]] bool containsAll(std::string_view text) const {
+        return std::visit([&](const auto& m) { return m.containsAll(text); }, matcher);
+    }
+
+    // С буфером вызывающего (см. AhoCorasick::containsAll): поиск не выделяет память и
+    // для больших наборов. Байтовому множеству и Teddy буфер не нужен.
+    [[nodiscard]] bool containsAll(std::string_view text, std::vector<uint64_t>& seen) const {
+        return std::visit(
+            [&](const auto& m) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(m)>, AhoCorasick>) {
+                    return m.containsAll(text, seen);
+                } else {
+                    return m.containsAll(text);
+                }
+            },
+            matcher);
+    }
+
+private:
+    using Engines = std::variant<ByteSetMatcher, TeddyMatcher, AhoCorasick>;
+
+    Engines matcher;
+
+    // Движок строится прямо в variant (in_place_type), без перемещения готового объекта.
+    static Engines build(const std::vector<std::string>& patterns, CaseMode mode, size_t memoryBudget) {
+        switch (chooseEngine(patterns, mode)) {
+            case MatchEngine::ByteSet:
+                return Engines(std::in_place_type<ByteSetMatcher>, patterns);
+            case MatchEngine::Teddy:
+                return Engines(std::in_place_type<TeddyMatcher>, patterns);
+            default:
+                return Engines(std::in_place_type<AhoCorasick>, patterns, mode, memoryBudget);
+        }
+    }
+};
+
+// Функция PatternSearch — то же, что AhoSearch, но с выбором движка по набору шаблонов.
+[[nodiscard]] inline bool PatternSearch(const std::string& text, const std::vector<std::string>& patterns, size_t count) {
+    return PatternMatcher(patterns).containsAll(text, count);
+}
+
+#endif // SMALLSET_HPP
@@ -0,0 +1,435 @@
+// ============================================================================
+// Данный заголовочный файл содержит суффиксный массив над всеми полями корпуса
+// (построение SA-IS) для подсчёта и поиска вхождений без просмотра корпуса.
+// ============================================================================
+
+#ifndef SUFFIX_HPP
+#define SUFFIX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "records.hpp"
+
+// Устройство индекса:
+// 1. text — поля всех записей подряд (запись 0: группы 0, 1, 2, затем запись 1 ...),
+//    после каждого поля — разделитель '\n'. Разделителя не бывает внутри поля (поля
+//    берутся из строк файла), а шаблон с '\n' не ищется, поэтому вхождения никогда
+//    не переходят через границу поля.
+// 2. suffixes — начала всех суффиксов text в лексикографическом порядке (uint32_t).
+//    Строится алгоритмом SA-IS за O(n) времени и ~6n байт памяти на время построения.
+// 3. buckets — для каждой пары первых байт b0 * 256 + b1 номер первого суффикса,
+//    начинающегося с неё (65537 чисел). Поиск сразу сужается до одной корзины.
+// 4. fieldStart — позиция в text начала каждого поля (номер поля record * 3 + group)
+//    и n в конце; по ней вхождение переводится в (record, group, offset).
+//
+// Логика поиска:
+// 1. Все вхождения шаблона — непрерывный отрезок суффиксного массива. Его границы
+//    находятся двумя двоичными поисками внутри корзины первых двух байт шаблона:
+//    O(m log n) сравнений байт, без просмотра корпуса.
+// 2. count — длина отрезка, locate — перевод каждого суффикса отрезка в запись,
+//    поле и смещение (двоичный поиск по fieldStart).
+//
+// Индекс учитывает регистр; для поиска без учёта регистра нужен обычный поиск по
+// корпусу. Сохранение и загрузка через mmap — в suffixfile.hpp.
+
+// ==========================================================================
+// | SuffixIndex(words) | count(pattern) | locate(pattern[, callback])     |
+// ==========================================================================
+
+inline constexpr char SUFFIX_FIELD_SEPARATOR = '\n';
+inline constexpr size_t SUFFIX_BUCKETS = 256 * 256;
+
+// Индекс поддерживает тексты до 2^31 - 1 байт: SA-IS работает со знаковыми int32_t.
+inline constexpr size_t SUFFIX_MAX_TEXT = static_cast<size_t>(INT32_MAX) - 1;
+
+// Вхождение, найденное по индексу: номер записи (с нуля), группа и смещение в поле.
+struct SuffixHit {
+    size_t record;
+    uint32_t group;
+    size_t offset;
+};
+
+// SaisSort строит суффиксный массив sa строки s длины n над алфавитом [0, alphabet).
+// Последний символ s[n - 1] должен быть единственным и наименьшим (0).
+// Алгоритм Нонга–Жана–Чана: суффиксы делятся на L- и S-типы, LMS-подстроки
+// сортируются индуцированием, при совпадении имён задача решается рекурсивно на
+// строке имён, затем порядок всех суффиксов индуцируется из порядка LMS-суффиксов.
+template <typename Char>
+void SaisSort(const Char* s, int32_t* sa, int32_t n, int32_t alphabet) {
+    // type[i] = 1 — суффикс i S-типа (меньше следующего), 0 — L-типа.
+    std::vector<uint8_t> type(static_cast<size_t>(n));
+    type[n - 1] = 1;
+    for (int32_t i = n - 2; i >= 0; --i) {
+        type[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && type[i + 1]) ? 1 : 0;
+    }
+    auto isLms = [&](int32_t i) { return i > 0 && type[i] && !type[i - 1]; };
+
+    std::vector<int32_t> counts(static_cast<size_t>(alphabet), 0);
+    for (int32_t i = 0; i < n; ++i) {
+        ++counts[static_cast<size_t>(s[i])];
+    }
+    std::vector<int32_t> bucket(static_cast<size_t>(alphabet));
+    auto bucketStarts = [&] {
+        int32_t sum = 0;
+        for (int32_t c = 0; c < alphabet; ++c) {
+            bucket[c] = sum;
+            sum += counts[c];
+        }
+    };
+    auto bucketEnds = [&] {
+        int32_t sum = 0;
+        for (int32_t c = 0; c < alphabet; ++c) {
+            sum += counts[c];
+            bucket[c] = sum;
+        }
+    };
+    auto induce = [&] {
+        bucketStarts();
+        for (int32_t i = 0; i < n; ++i) {
+            const int32_t j = sa[i] - 1;
+            if (sa[i] > 0 && !type[j]) {
+                sa[bucket[s[j]]++] = j;
+            }
+        }
+        bucketEnds();
+        for (int32_t i = n - 1; i >= 0; --i) {
+            const int32_t j = sa[i] - 1;
+            if (sa[i] > 0 && type[j]) {
+                sa[--bucket[s[j]]] = j;
+            }
+        }
+    };
+
+    // 1. Сортировка LMS-подстрок: LMS-позиции в концы корзин, затем индуцирование.
+    std::fill(sa, sa + n, -1);
+    bucketEnds();
+    for (int32_t i = 1; i < n; ++i) {
+        if (isLms(i)) {
+            sa[--bucket[s[i]]] = i;
+        }
+    }
+    induce();
+
+    // 2. Имена LMS-подстрок: отсортированные LMS-позиции сдвигаются в начало sa,
+    //    имена пишутся в sa[n1 + pos / 2] (LMS-позиции отстоят хотя бы на 2).
+    int32_t n1 = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        if (isLms(sa[i])) {
+            sa[n1++] = sa[i];
+        }
+    }
+    std::fill(sa + n1, sa + n, -1);
+    int32_t names = 0;
+    int32_t previous = -1;
+    for (int32_t i = 0; i < n1; ++i) {
+        const int32_t pos = sa[i];
+        bool differs = false;
+        for (int32_t d = 0; d < n; ++d) {
+            if (previous == -1 || s[pos + d] != s[previous + d] || type[pos + d] != type[previous + d]) {
+                differs = true;
+                break;
+            }
+            if (d > 0 && (isLms(pos + d) || isLms(previous + d))) {
+                break;
+            }
+        }
+        if (differs) {
+            ++names;
+            previous = pos;
+        }
+        sa[n1 + pos / 2] = names - 1;
+    }
+    for (int32_t i = n - 1, j = n - 1; i >= n1; --i) {
+        if (sa[i] >= 0) {
+            sa[j--] = sa[i];
+        }
+    }
+
+    // 3. Порядок LMS-суффиксов: рекурсия, если имена не все различны.
+    int32_t* reduced = sa + n - n1;
+    if (names < n1) {
+        SaisSort(reduced, sa, n1, names);
+    } else {
+        for (int32_t i = 0; i < n1; ++i) {
+            sa[reduced[i]] = i;
+        }
+    }
+
+    // 4. LMS-суффиксы в порядке sa — в концы корзин, затем индуцирование всех суффиксов.
+    for (int32_t i = 1, j = 0; i < n; ++i) {
+        if (isLms(i)) {
+            reduced[j++] = i;
+        }
+    }
+    for (int32_t i = 0; i < n1; ++i) {
+        sa[i] = reduced[sa[i]];
+    }
+    std::fill(sa + n1, sa + n, -1);
+    bucketEnds();
+    for (int32_t i = n1 - 1; i >= 0; --i) {
+        const int32_t j = sa[i];
+        sa[i] = -1;
+        sa[--bucket[s[j]]] = j;
+    }
+    induce();
+}
+
+// SortPositions сортирует позиции вхождений. Частый шаблон даёт сотни тысяч
+// позиций в случайном порядке суффиксного массива; поразрядная сортировка (три
+// прохода по 11 бит) обходит их последовательно и на таких объёмах в разы быстрее
+// std::sort. Короткие списки сортируются std::sort.
+inline void SortPositions(std::vector<uint32_t>& positions) {
+    constexpr size_t RADIX_MIN_SIZE = 4096;
+    constexpr uint32_t DIGIT_BITS = 11;
+    constexpr size_t DIGITS = size_t{1} << DIGIT_BITS;
+    if (positions.size() < RADIX_MIN_SIZE) {
+        std::sort(positions.begin(), positions.end());
+        return;
+    }
+    std::vector<uint32_t> buffer(positions.size());
+    std::vector<size_t> offsets(DIGITS);
+    for (uint32_t shift = 0; shift < 32; shift += DIGIT_BITS) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (const uint32_t pos : positions) {
+            ++offsets[(pos >> shift) & (DIGITS - 1)];
+        }
+        size_t sum = 0;
+        for (size_t& offset : offsets) {
+            const size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (const uint32_t pos : positions) {
+            buffer[offsets[(pos >> shift) & (DIGITS - 1)]++] = pos;
+        }
+        positions.swap(buffer);
+    }
+}
+
+// Класс SuffixIndex — суффиксный массив над полями одного RecordStore. После
+// построения не зависит от хранилища: текст полей хранится в самом индексе.
+class SuffixIndex {
+public:
+    explicit SuffixIndex(const RecordStore& words) {
+        const size_t fields = words.size() * RecordStore::GROUPS;
+        if (words.bytes() + fields > SUFFIX_MAX_TEXT) {
+            throw std::length_error("SuffixIndex: corpus is too large");
+        }
+
+        text.reserve(words.bytes() + fields);
+        fieldStart.reserve(fields + 1);
+        for (size_t i = 0; i < words.size(); ++i) {
+            const RecordView v = words[i];
+            for (size_t g = 0; g < RecordStore::GROUPS; ++g) {
+                if (v[g].find(SUFFIX_FIELD_SEPARATOR) != std::string_view::npos) {
+                    throw std::invalid_argument("SuffixIndex: field contains a line break");
+                }
+                fieldStart.push_back(text.size());
+                text.insert(text.end(), v[g].begin(), v[g].end());
+                text.push_back(SUFFIX_FIELD_SEPARATOR);
+            }
+        }
+        fieldStart.push_back(text.size());
+
+        buildSuffixes();
+        buildBuckets();
+        bindImage();
+    }
+
+    // Как и AhoCorasick, индекс указывает в свои векторы: копирование запрещено.
+    SuffixIndex(const SuffixIndex&) = delete;
+    SuffixIndex& operator=(const SuffixIndex&) = delete;
+    SuffixIndex(SuffixIndex&&) noexcept = default;
+    SuffixIndex& operator=(SuffixIndex&&) noexcept = default;
+
+    // Image — массивы, по которым идёт поиск: свои векторы построенного индекса или
+    // отображённый файл (см. suffixfile.hpp).
+    struct Image {
+        size_t records;
+        size_t textBytes;
+        const char* text;            // textBytes
+        const uint32_t* suffixes;    // textBytes
+        const uint32_t* buckets;     // SUFFIX_BUCKETS + 1
+        const uint64_t* fieldStart;  // records * GROUPS + 1
+    };
+
+    // Индекс поверх готовых массивов; backing держит их память, пока жив индекс.
+    [[nodiscard]] static SuffixIndex fromImage(const Image& image, std::shared_ptr<const void> backing) {
+        return SuffixIndex(image, std::move(backing));
+    }
+
+    [[nodiscard]] const Image& image() const { return view; }
+
+    [[nodiscard]] size_t records() const { return view.records; }
+    [[nodiscard]] size_t textBytes() const { return view.textBytes; }
+
+    // Размер индекса в байтах: текст, суффиксный массив, корзины и начала полей.
+    [[nodiscard]] size_t memoryBytes() const {
+        return view.textBytes * (1 + sizeof(uint32_t)) + (SUFFIX_BUCKETS + 1) * sizeof(uint32_t) +
+               (view.records * RecordStore::GROUPS + 1) * sizeof(uint64_t);
+    }
+
+    // Индекс построен по тому же корпусу, что words (совпадают число записей и байт).
+    [[nodiscard]] bool matches(const RecordStore& words) const {
+        return view.records == words.size() && view.textBytes == words.bytes() + words.size() * RecordStore::GROUPS;
+    }
+
+    // Отрезок [first, last) суффиксного массива, суффиксы которого начинаются с
+    // pattern. Пустой шаблон и шаблон с разделителем полей не ищутся (пустой отрезок).
+    [[nodiscard]] std::pair<size_t, size_t> range(std::string_view pattern) const {
+        if (pattern.empty() || pattern.find(SUFFIX_FIELD_SEPARATOR) != std::string_view::npos) {
+            return {0, 0};
+        }
+        const size_t b0 = static_cast<uint8_t>(pattern[0]);
+        if (pattern.size() == 1) {
+            return {view.buckets[b0 * 256], view.buckets[(b0 + 1) * 256]};
+        }
+        const size_t key = b0 * 256 + static_cast<uint8_t>(pattern[1]);
+        size_t first = view.buckets[key];
+        size_t last = view.buckets[key + 1];
+        if (pattern.size() == 2 || first == last) {
+            return {first, last};
+        }
+
+        // Внутри корзины первые два байта совпадают — сравнение идёт с третьего.
+        const std::string_view rest = pattern.substr(2);
+        auto compare = [&](size_t k) {
+            const size_t pos = view.suffixes[k] + 2;
+            const size_t length = std::min(rest.size(), view.textBytes - pos);
+            const int c = std::memcmp(view.text + pos, rest.data(), length);
+            return c != 0 ? c : (length < rest.size() ? -1 : 0);
+        };
+        size_t lo = first;
+        size_t hi = last;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (compare(mid) < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        first = lo;
+        hi = last;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (compare(mid) <= 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return {first, lo};
+    }
+
+    [[nodiscard]] size_t count(std::string_view pattern) const {
+        const auto [first, last] = range(pattern);
+        return last - first;
+    }
+
+    // Переводит позицию text в запись, группу и смещение в поле.
+    [[nodiscard]] SuffixHit hitAt(size_t pos) const {
+        const uint64_t* begin = view.fieldStart;
+        const uint64_t* end = view.fieldStart + view.records * RecordStore::GROUPS + 1;
+        const size_t field = static_cast<size_t>(std::upper_bound(begin, end, uint64_t{pos}) - begin) - 1;
+        return SuffixHit{field / RecordStore::GROUPS, static_cast<uint32_t>(field % RecordStore::GROUPS),
+                         pos - static_cast<size_t>(begin[field])};
+    }
+
+    // Вызывает callback(const SuffixHit&) для каждого вхождения в порядке суффиксного
+    // массива (не в порядке корпуса).
+    template <typename Callback>
+    void locate(std::string_view pattern, Callback&& callback) const {
+        const auto [first, last] = range(pattern);
+        for (size_t k = first; k < last; ++k) {
+            callback(hitAt(view.suffixes[k]));
+        }
+    }
+
+    // Все вхождения в порядке корпуса: по записи, группе и смещению. Позиции
+    // сортируются (SortPositions), после чего поле каждой ищется галопом от поля предыдущей: для
+    // частых шаблонов это почти линейный проход по fieldStart вместо двоичного поиска
+    // на каждое вхождение.
+    [[nodiscard]] std::vector<SuffixHit> locate(std::string_view pattern) const {
+        const auto [first, last] = range(pattern);
+        std::vector<uint32_t> positions(view.suffixes + first, view.suffixes + last);
+        SortPositions(positions);
+
+        std::vector<SuffixHit> hits;
+        hits.reserve(positions.size());
+        const size_t fields = view.records * RecordStore::GROUPS;
+        size_t field = 0;
+        for (const uint32_t pos : positions) {
+            // Искомое поле — последнее с fieldStart[field] <= pos; шаг удваивается, пока
+            // не перешагнёт его, затем двоичный поиск внутри последнего шага.
+            size_t step = 1;
+            size_t bound = field;
+            while (bound + step <= fields && view.fieldStart[bound + step] <= pos) {
+                bound += step;
+                step *= 2;
+            }
+            const uint64_t* begin = view.fieldStart + bound;
+            const uint64_t* end = view.fieldStart + std::min(bound + step, fields + 1);
+            field = bound + static_cast<size_t>(std::upper_bound(begin, end, uint64_t{pos}) - begin) - 1;
+            hits.push_back(SuffixHit{field / RecordStore::GROUPS, static_cast<uint32_t>(field % RecordStore::GROUPS),
+                                     pos - static_cast<size_t>(view.fieldStart[field])});
+        }
+        return hits;
+    }
+
+private:
+    // Вектор, а не std::string: при перемещении короткой строки её буфер меняет адрес.
+    std::vector<char> text;
+    std::vector<uint32_t> suffixes;
+    std::vector<uint32_t> buckets;
+    std::vector<uint64_t> fieldStart;
+    Image view{};
+    std::shared_ptr<const void> backing;
+
+    SuffixIndex(const Image& image, std::shared_ptr<const void> memory) : view(image), backing(std::move(memory)) {}
+
+    // SA-IS нужен единственный наименьший символ в конце: байты сдвигаются на 1,
+    // в конец дописывается 0, а его суффикс (первый в порядке) отбрасывается.
+    void buildSuffixes() {
+        if (text.empty()) {
+            return;
+        }
+        const int32_t n = static_cast<int32_t>(text.size()) + 1;
+        std::vector<int32_t> sa(static_cast<size_t>(n));
+        {
+            std::vector<uint16_t> shifted(static_cast<size_t>(n));
+            for (size_t i = 0; i < text.size(); ++i) {
+                shifted[i] = static_cast<uint16_t>(static_cast<uint8_t>(text[i]) + 1);
+            }
+            shifted[text.size()] = 0;
+            SaisSort(shifted.data(), sa.data(), n, 257);
+        }
+        suffixes.assign(sa.begin() + 1, sa.end());
+    }
+
+    // Корзины по первым двум байтам; суффикс из одного байта (последний разделитель)
+    // попадает в корзину с нулевым вторым байтом и стоит в ней первым.
+    void buildBuckets() {
+        buckets.assign(SUFFIX_BUCKETS + 1, 0);
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            const size_t b1 = pos + 1 < text.size() ? static_cast<uint8_t>(text[pos + 1]) : 0;
+            ++buckets[static_cast<uint8_t>(text[pos]) * 256 + b1 + 1];
+        }
+        for (size_t k = 1; k <= SUFFIX_BUCKETS; ++k) {
+            buckets[k] += buckets[k - 1];
+        }
+    }
+
+    void bindImage() {
+        view = Image{fieldStart.size() / RecordStore::GROUPS, text.size(), text.data(), suffixes.data(),
+                     buckets.data(), fieldStart.data()};
+    }
+};
+
+#endif // SUFFIX_HPP
@@ -0,0 +1,158 @@
+// ============================================================================
+// Данный заголовочный файл содержит двоичный формат суффиксного индекса корпуса:
+// запись в файл и загрузку через отображение в память (mmap).
+// ============================================================================
+
+#ifndef SUFFIXFILE_HPP
+#define SUFFIXFILE_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "file.hpp"
+#include "suffix.hpp"
+
+// Формат файла (версия 1):
+// 1. Заголовок SuffixFileHeader (первые SUFFIX_FILE_HEADER_SPACE байт): сигнатура,
+//    версия, метка порядка байт, число записей и байт текста, затем смещения и
+//    размеры секций в байтах от начала файла.
+// 2. Секции из SuffixIndex::Image в порядке: fieldStart (uint64_t), buckets,
+//    suffixes (uint32_t), text (байты). Каждая начинается с адреса, кратного
+//    SUFFIX_FILE_ALIGN.
+//
+// Как и у автомата (acfile.hpp), в секциях только номера и смещения: LoadSuffixIndex
+// отображает файл и направляет Image прямо в отображение, так что загрузка не
+// зависит от размера корпуса. Проверяются заголовок, границы секций и начала полей;
+// суффиксный массив не проверяется — файл должен быть записан SaveSuffixIndex.
+
+// ==================================================================
+// | SaveSuffixIndex(index, path) | LoadSuffixIndex(path) -> SuffixIndex |
+// ==================================================================
+
+inline constexpr char SUFFIX_FILE_MAGIC[8] = {'L', 'A', 'B', 'S', 'U', 'F', 'F', 'X'};
+inline constexpr uint32_t SUFFIX_FILE_VERSION = 1;
+inline constexpr uint32_t SUFFIX_FILE_BYTE_ORDER = 0x01020304;
+inline constexpr size_t SUFFIX_FILE_ALIGN = 64;
+inline constexpr size_t SUFFIX_FILE_HEADER_SPACE = 128;
+inline constexpr size_t SUFFIX_FILE_SECTIONS = 4;
+
+struct SuffixFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t records;
+    uint64_t textBytes;
+    // Смещение от начала файла и размер в байтах каждой секции.
+    uint64_t offset[SUFFIX_FILE_SECTIONS];
+    uint64_t bytes[SUFFIX_FILE_SECTIONS];
+};
+
+static_assert(sizeof(SuffixFileHeader) <= SUFFIX_FILE_HEADER_SPACE,
+              "SuffixFileHeader must fit into its reserved space");
+
+// Размер каждой секции в байтах по параметрам индекса.
+[[nodiscard]] inline std::array<uint64_t, SUFFIX_FILE_SECTIONS> SuffixFileSectionBytes(uint64_t records,
+                                                                                      uint64_t textBytes) {
+    return {(records * RecordStore::GROUPS + 1) * sizeof(uint64_t), (SUFFIX_BUCKETS + 1) * sizeof(uint32_t),
+            textBytes * sizeof(uint32_t), textBytes};
+}
+
+inline void SaveSuffixIndex(const SuffixIndex& index, const std::string& path) {
+    const SuffixIndex::Image& image = index.image();
+    const std::array<const char*, SUFFIX_FILE_SECTIONS> data = {
+        reinterpret_cast<const char*>(image.fieldStart), reinterpret_cast<const char*>(image.buckets),
+        reinterpret_cast<const char*>(image.suffixes), image.text};
+    const auto sizes = SuffixFileSectionBytes(image.records, image.textBytes);
+
+    SuffixFileHeader header{};
+    std::memcpy(header.magic, SUFFIX_FILE_MAGIC, sizeof(header.magic));
+    header.version = SUFFIX_FILE_VERSION;
+    header.byteOrder = SUFFIX_FILE_BYTE_ORDER;
+    header.records = image.records;
+    header.textBytes = image.textBytes;
+
+    uint64_t pos = SUFFIX_FILE_HEADER_SPACE;
+    for (size_t k = 0; k < SUFFIX_FILE_SECTIONS; ++k) {
+        header.offset[k] = pos;
+        header.bytes[k] = sizes[k];
+        pos += sizes[k];
+        pos = (pos + SUFFIX_FILE_ALIGN - 1) / SUFFIX_FILE_ALIGN * SUFFIX_FILE_ALIGN;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open index file: " + path);
+    }
+    static const char zeros[SUFFIX_FILE_HEADER_SPACE] = {};
+    uint64_t written = 0;
+    auto pad = [&](uint64_t to) {
+        file.write(zeros, static_cast<std::streamsize>(to - written));
+        written = to;
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    written = sizeof(header);
+    for (size_t k = 0; k < SUFFIX_FILE_SECTIONS; ++k) {
+        pad(header.offset[k]);
+        file.write(data[k], static_cast<std::streamsize>(sizes[k]));
+        written += sizes[k];
+    }
+    pad(pos);
+    if (!file) {
+        throw std::runtime_error("Failed to write index file: " + path);
+    }
+}
+
+[[nodiscard]] inline SuffixIndex LoadSuffixIndex(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    const std::string_view bytes = file->view();
+
+    SuffixFileHeader header;
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error("Invalid index file: " + path);
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, SUFFIX_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Invalid index file: " + path);
+    }
+    if (header.version != SUFFIX_FILE_VERSION) {
+        throw std::runtime_error("Unsupported index file version: " + std::to_string(header.version));
+    }
+    if (header.byteOrder != SUFFIX_FILE_BYTE_ORDER) {
+        throw std::runtime_error("Index file has a different byte order: " + path);
+    }
+    if (header.textBytes > SUFFIX_MAX_TEXT || header.records > header.textBytes) {
+        throw std::runtime_error("Invalid index file: " + path);
+    }
+
+    const auto sizes = SuffixFileSectionBytes(header.records, header.textBytes);
+    std::array<const char*, SUFFIX_FILE_SECTIONS> data{};
+    for (size_t k = 0; k < SUFFIX_FILE_SECTIONS; ++k) {
+        if (header.bytes[k] != sizes[k] || header.offset[k] % SUFFIX_FILE_ALIGN != 0 ||
+            header.offset[k] > bytes.size() || sizes[k] > bytes.size() - header.offset[k]) {
+            throw std::runtime_error("Invalid index file: " + path);
+        }
+        data[k] = bytes.data() + header.offset[k];
+    }
+
+    SuffixIndex::Image image{};
+    image.records = header.records;
+    image.textBytes = header.textBytes;
+    image.fieldStart = reinterpret_cast<const uint64_t*>(data[0]);
+    image.buckets = reinterpret_cast<const uint32_t*>(data[1]);
+    image.suffixes = reinterpret_cast<const uint32_t*>(data[2]);
+    image.text = data[3];
+    const size_t fields = image.records * RecordStore::GROUPS;
+    if (image.fieldStart[0] != 0 || image.fieldStart[fields] != image.textBytes ||
+        image.buckets[SUFFIX_BUCKETS] != image.textBytes) {
+        throw std::runtime_error("Invalid index file: " + path);
+    }
+
+    return SuffixIndex::fromImage(image, std::move(file));
+}
+
+#endif // SUFFIXFILE_HPP
@@ -0,0 +1,207 @@
+// ============================================================================
+// Данный заголовочный файл содержит функции для работы с UTF-8: проверку
+// корректности текста и перевод байтовых позиций совпадений в позиции символов.
+// ============================================================================
+
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "simd.hpp"
+
+// Логика:
+// Алгоритмы поиска (KMP, Ахо–Корасик) работают с байтами: шаблон в UTF-8 — это просто
+// последовательность байт, поэтому сами автоматы менять не нужно. Неверна только
+// позиция: "Щ" занимает два байта, и байтовая позиция не совпадает с номером символа.
+//
+// 1. ValidateUtf8 проверяет текст по RFC 3629 (без overlong-форм, суррогатов и
+//    символов больше U+10FFFF). Блоки из одних ASCII-байт пропускаются целиком
+//    SIMD-проверкой старших битов, скалярно разбираются только многобайтовые символы.
+// 2. Номер символа для байтовой позиции — число байт в префиксе, не являющихся
+//    байтами продолжения (10xxxxxx). Они считаются SIMD-сравнением и popcount.
+// 3. Utf8Offsets строит для длинной строки индекс лениво — при первом запросе:
+//    число символов перед каждым блоком из UTF8_BLOCK байт. Тогда перевод позиции
+//    стоит одного чтения индекса и подсчёта внутри блока. Короткие строки
+//    (поля data.txt) считаются напрямую, без индекса.
+
+// ===========================================================================
+// | ValidateUtf8(text) | CountCodepoints(text) | Utf8Offsets(text).toCodepoint |
+// ===========================================================================
+
+inline bool Utf8IsContinuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Проверяет один многобайтовый символ с позиции i; при успехе сдвигает i за него.
+inline bool Utf8ValidateSequence(const unsigned char* s, size_t n, size_t& i) {
+    const unsigned char c = s[i];
+    size_t length;
+    unsigned char lo = 0x80, hi = 0xBF;
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        if (c == 0xE0) lo = 0xA0;        // overlong
+        if (c == 0xED) hi = 0x9F;        // суррогаты U+D800..U+DFFF
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        if (c == 0xF0) lo = 0x90;        // overlong
+        if (c == 0xF4) hi = 0x8F;        // больше U+10FFFF
+    } else {
+        return false;
+    }
+
+    if (i + length > n) {
+        return false;
+    }
+    if (s[i + 1] < lo || s[i + 1] > hi) {
+        return false;
+    }
+    for (size_t k = 2; k < length; ++k) {
+        if (!Utf8IsContinuation(s[i + k])) {
+            return false;
+        }
+    }
+    i += length;
+    return true;
+}
+
+inline size_t Utf8CountScalar(const unsigned char* s, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += !Utf8IsContinuation(s[i]);
+    }
+    return count;
+}
+
+#if LAB_SIMD_X86
+
+// Длина ASCII-префикса начиная с i (кратно блоку; хвост досчитывает вызывающий).
+inline size_t Utf8SkipAsciiSSE2(const unsigned char* s, size_t n, size_t i) {
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        if (_mm_movemask_epi8(v) != 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+inline size_t Utf8SkipAsciiAVX2(const unsigned char* s, size_t n, size_t i) {
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        if (_mm256_movemask_epi8(v) != 0) {
+            break;
+        }
+    }
+    return Utf8SkipAsciiSSE2(s, n, i);
+}
+
+// Байт продолжения как int8_t лежит в [-128, -65], поэтому "не продолжение" — это v > -65.
+inline size_t Utf8CountSSE2(const unsigned char* s, size_t n) {
+    const __m128i limit = _mm_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        count += static_cast<size_t>(__builtin_popcount(
+            static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, limit)))));
+    }
+    return count + Utf8CountScalar(s + i, n - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+inline size_t Utf8CountAVX2(const unsigned char* s, size_t n) {
+    const __m256i limit = _mm256_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        count += static_cast<size_t>(__builtin_popcount(
+            static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, limit)))));
+    }
+    return count + Utf8CountScalar(s + i, n - i);
+}
+
+#endif // LAB_SIMD_X86
+
+inline size_t Utf8SkipAscii(const unsigned char* s, size_t n, size_t i) {
+#if LAB_SIMD_X86
+    i = DetectSimd() == SimdLevel::AVX2 ? Utf8SkipAsciiAVX2(s, n, i) : Utf8SkipAsciiSSE2(s, n, i);
+#endif
+    while (i < n && s[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+[[nodiscard]] inline bool ValidateUtf8(std::string_view text) {
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        i = Utf8SkipAscii(s, n, i);
+        // После ASCII-участка разбираем подряд идущие многобайтовые символы.
+        while (i < n && s[i] >= 0x80) {
+            if (!Utf8ValidateSequence(s, n, i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Число символов (кодовых точек) в корректном UTF-8 тексте.
+[[nodiscard]] inline size_t CountCodepoints(std::string_view text) {
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+#if LAB_SIMD_X86
+    if (DetectSimd() == SimdLevel::AVX2) {
+        return Utf8CountAVX2(s, text.size());
+    }
+    return Utf8CountSSE2(s, text.size());
+#else
+    return Utf8CountScalar(s, text.size());
+#endif
+}
+
+// Класс Utf8Offsets переводит байтовые позиции внутри одной строки в номера символов.
+// Индекс по блокам строится при первом обращении к длинной строке и затем
+// переиспользуется для всех совпадений в ней.
+class Utf8Offsets {
+public:
+    static constexpr size_t UTF8_BLOCK = 256;
+
+    explicit Utf8Offsets(std::string_view text) : text_(text) {}
+
+    // byte — позиция начала символа (или text.size()); результат — номер этого символа.
+    [[nodiscard]] size_t toCodepoint(size_t byte) {
+        if (text_.size() <= UTF8_BLOCK) {
+            return CountCodepoints(text_.substr(0, byte));
+        }
+        if (blocks_.empty()) {
+            build();
+        }
+        const size_t block = byte / UTF8_BLOCK;
+        const size_t start = block * UTF8_BLOCK;
+        return blocks_[block] + CountCodepoints(text_.substr(start, byte - start));
+    }
+
+private:
+    std::string_view text_;
+    // blocks_[k] — число символов в text_[0, k * UTF8_BLOCK).
+    std::vector<size_t> blocks_;
+
+    void build() {
+        blocks_.reserve(text_.size() / UTF8_BLOCK + 1);
+        size_t count = 0;
+        for (size_t start = 0; start <= text_.size(); start += UTF8_BLOCK) {
+            blocks_.push_back(count);
+            count += CountCodepoints(text_.substr(start, UTF8_BLOCK));
+        }
+    }
+};
+
+#endif // UTF8_HPP